@@ -20,10 +20,14 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <eosio/binary_extension.hpp>
 #include <eosio/eosio.hpp>
 #include <eosio/singleton.hpp>
 #include <eosio/time.hpp>
 #include <stdint.h>
+#include <algorithm>
+#include <map>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -75,12 +79,77 @@ public:
      *
      * @param assoc_id User custom id to be used in 'receiverand' callback to
      *                 identify the request.
-     * @param signing_value Value used to sign the random value
+     * @param signing_value Value used to sign the random value, or 0 to have the
+     *                      contract derive one from the job id, the active key and
+     *                      the transaction. Derived values are not recorded in the
+     *                      signing values tables: the oracle signs them along with
+     *                      the job id, so they can not collide with any other.
      * @param caller Smart contract acount that implement 'reveiverand' callback
+     * @param count Optional number of random values derived from the signature, 1 if omitted.
+     *              With more than one, the values are delivered together to the
+     *              'receiverands' callback, value i being sha256(random_value || i)
+     *              where random_value is the signature given to setrand and i is a
+     *              little-endian uint32 starting at 0.
      */
-    ACTION requestrand(uint64_t assoc_id, uint64_t signing_value, const eosio::name& caller);
+    ACTION requestrand(uint64_t assoc_id, uint64_t signing_value, const eosio::name& caller,
+                       const eosio::binary_extension<uint32_t>& count);
     using requestrand_action = eosio::action_wrapper<"requestrand"_n, &orng::requestrand>;
 
+    /**
+     * Ask for several random values at once. The jobs get consecutive ids and
+     * each one is delivered through its own 'receiverand' callback.
+     *
+     * @param requests Pairs of assoc_id and signing_value, one per random value,
+     *                 a signing value of 0 being derived as in requestrand
+     * @param caller Smart contract acount that implement 'reveiverand' callback
+     * @note like requestrand, the signing values are recorded in the legacy v1 table under self scope only if the caller opted in with setv1compat
+     */
+    ACTION requestrands(const std::vector<std::pair<uint64_t, uint64_t>>& requests, const eosio::name& caller);
+    using requestrands_action = eosio::action_wrapper<"requestrands"_n, &orng::requestrands>;
+
+    /**
+     * Registers a stream of random values, one every period seconds from now,
+     * without a request per value. The oracle signs the stream id, the
+     * sequence number and the seed of each value, and delivers it through the
+     * 'receiverand' callback with the assoc_id of the stream.
+     *
+     * @param caller Smart contract acount that implement 'reveiverand' callback, it pays the stream row
+     * @param assoc_id The id delivered with every value of the stream
+     * @param period Seconds between two values, at least the minimum set by setstreamcap
+     * @param max_outstanding Values kept due while the oracle is behind, older ones are skipped
+     * @param seed Any value chosen by the caller, part of every signed message
+     * @note a dapp has at most the open streams set by setstreamcap, 4 by default
+     */
+    ACTION subscribe(const eosio::name& caller, uint64_t assoc_id, uint32_t period, uint32_t max_outstanding, uint64_t seed);
+    using subscribe_action = eosio::action_wrapper<"subscribe"_n, &orng::subscribe>;
+
+    /**
+     * Removes a stream, authorized by its caller, or by the oracle to close a
+     * stream it refuses to serve.
+     */
+    ACTION unsubscribe(uint64_t stream_id);
+    using unsubscribe_action = eosio::action_wrapper<"unsubscribe"_n, &orng::unsubscribe>;
+
+    /**
+     * Used by the oracle to limit the streams it serves. The limits apply to
+     * new streams, the open ones are closed with unsubscribe.
+     *
+     * @param max_streams The open streams allowed per dapp, 4 by default
+     * @param min_period The shortest period of a new stream in seconds, 5 by default
+     */
+    ACTION setstreamcap(uint32_t max_streams, uint32_t min_period);
+    using setstreamcap_action = eosio::action_wrapper<"setstreamcap"_n, &orng::setstreamcap>;
+
+    /**
+     * Used by the oracle to set the next due value of a stream.
+     *
+     * @param stream_id The stream of the value
+     * @param seq The sequence number of the value, next_seq of the stream
+     * @param random_value The signature of the stream message by the key of the stream
+     */
+    ACTION setstreamrnd(uint64_t stream_id, uint64_t seq, const std::string& random_value);
+    using setstreamrnd_action = eosio::action_wrapper<"setstreamrnd"_n, &orng::setstreamrnd>;
+
     /**
      * Sets the signing values in the signing values table under self scope according to the v1 version of this contract. Maintains backward compatibility
      *
@@ -90,12 +159,45 @@ public:
     ACTION v1rrcompat(uint64_t signing_value);
     using v1rrcompat_action = eosio::action_wrapper<"v1rrcompat"_n, &orng::v1rrcompat>;
 
+    /**
+     * Enables/Disables recording the signing values of a dapp in the legacy v1
+     * table under self scope. A dapp that never set it follows the setting of the
+     * contract account itself, which is off on a new contract and on after
+     * upgrading one, so the existing dapps keep their legacy rows.
+     *
+     * @param dapp account name of dapp, or the contract to set the default
+     * @param enabled record the signing values of the dapp under self scope or not
+     * @note it can be set by the dapp or by the contract itself
+     */
+    ACTION setv1compat(const eosio::name& dapp, bool enabled);
+    using setv1compat_action = eosio::action_wrapper<"setv1compat"_n, &orng::setv1compat>;
+
+    /**
+     * Removes signing values from the legacy v1 table under self scope that are
+     * no longer tracked by the active public-key. It resumes from where the
+     * previous call stopped and starts over after reaching the end of the table.
+     *
+     * @param rows_num The number of rows to be checked
+     */
+    ACTION purgev1vals(uint64_t rows_num);
+    using purgev1vals_action = eosio::action_wrapper<"purgev1vals"_n, &orng::purgev1vals>;
+
     /**
      * Used by the oracle to set the generated random value
      */
     ACTION setrand(uint64_t job_id, const std::string& random_value);
     using setrand_action = eosio::action_wrapper<"setrand"_n, &orng::setrand>;
 
+    /**
+     * Used by the oracle to set the generated random values of several jobs
+     * in a single action. Jobs are verified and dispatched in the given order,
+     * so sorting them by job id lets consecutive jobs share the signing key lookup.
+     *
+     * @param results Pairs of job id and its signed value
+     */
+    ACTION setrandbatch(const std::vector<std::pair<uint64_t, std::string>>& results);
+    using setrandbatch_action = eosio::action_wrapper<"setrandbatch"_n, &orng::setrandbatch>;
+
     /**
      * Removes jobs from the jobs table. The Oracle calls on it passing a list
      * of dangling jobs.
@@ -105,6 +207,160 @@ public:
     ACTION killjobs(const std::vector<uint64_t>& job_ids);
     using killjobs_action = eosio::action_wrapper<"killjobs"_n, &orng::killjobs>;
 
+    /**
+     * Removes the jobs requested more than max_age seconds ago, oldest first.
+     * Job ids grow with the request time, so the lanes are walked together in
+     * job id order and the walk stops at the first job that is young enough.
+     *
+     * @param max_age age in seconds from which a job is removed
+     * @param max_rows The maximum number of jobs to be removed
+     * @param notify send jobexpired for each removed job, which notifies its dapp
+     */
+    ACTION expirejobs(uint32_t max_age, uint64_t max_rows, bool notify);
+    using expirejobs_action = eosio::action_wrapper<"expirejobs"_n, &orng::expirejobs>;
+
+    /**
+     * Notifies the dapp that its job was removed by expirejobs without a
+     * random value. Only the contract itself can call it.
+     *
+     * @param job_id The id of the removed job
+     * @param assoc_id User custom id given to requestrand
+     * @param caller The dapp that requested the job
+     */
+    ACTION jobexpired(uint64_t job_id, uint64_t assoc_id, const eosio::name& caller);
+    using jobexpired_action = eosio::action_wrapper<"jobexpired"_n, &orng::jobexpired>;
+
+    /**
+     * Sets the maximum number of jobs of a dapp waiting for their random
+     * value. Requests going over it are rejected until jobs are fulfilled or killed.
+     *
+     * @param dapp account name of dapp
+     * @param max_jobs maximum number of jobs in flight, zero removes the limit
+     */
+    ACTION setinflight(const eosio::name& dapp, uint64_t max_jobs);
+    using setinflight_action = eosio::action_wrapper<"setinflight"_n, &orng::setinflight>;
+
+    /**
+     * Gets the number of jobs in flight of every dapp having jobs, in account
+     * name order. It does not modify any table.
+     *
+     * @return Pairs of dapp and its number of jobs in flight
+     */
+    [[eosio::action]] std::vector<std::pair<eosio::name, uint64_t>> getdepths();
+    using getdepths_action = eosio::action_wrapper<"getdepths"_n, &orng::getdepths>;
+
+    /**
+     * Sets how many jobs of the paid lane are served for every job of the
+     * free lane by getnextjobs.
+     *
+     * @param paid_weight number of paid jobs per free job, at least 1
+     */
+    ACTION setlaneweight(uint64_t paid_weight);
+    using setlaneweight_action = eosio::action_wrapper<"setlaneweight"_n, &orng::setlaneweight>;
+
+    // job waiting for its random value, as returned by getnextjobs
+    struct pending_job {
+        uint64_t    id;
+        uint64_t    signing_value;
+        eosio::name caller;
+        bool        paid;
+        bool        derived; // sign signing_value and id, see requestrand
+    };
+
+    /**
+     * Gets the next jobs to fulfill. Jobs of dapps whose bandwidth payer
+     * accepted to pay are in the paid lane, the others in the free lane. Each
+     * lane is served in job id order across the shards, taking up to
+     * paid_weight paid jobs for every free job. It does not modify any table.
+     *
+     * @param max_jobs maximum number of jobs returned
+     * @return The jobs in the order they should be fulfilled
+     */
+    [[eosio::action]] std::vector<pending_job> getnextjobs(uint64_t max_jobs);
+    using getnextjobs_action = eosio::action_wrapper<"getnextjobs"_n, &orng::getnextjobs>;
+
+    /**
+     * Splits the next jobs into shards, job_id % shards, so each oracle worker
+     * can own a shard. The jobs requested before keep their shard, and the
+     * shards can be changed again once they are all gone.
+     *
+     * @param shards number of shards, between 1 and 16
+     */
+    ACTION setshards(uint64_t shards);
+    using setshards_action = eosio::action_wrapper<"setshards"_n, &orng::setshards>;
+
+    /**
+     * Used by the oracle worker owning a shard to set the generated random
+     * values of its jobs, as setrandbatch does. Fails if a job belongs to
+     * another shard.
+     *
+     * @param shard The shard of the jobs
+     * @param results Pairs of job id and its signed value
+     */
+    ACTION setrandshard(uint64_t shard, const std::vector<std::pair<uint64_t, std::string>>& results);
+    using setrandshard_action = eosio::action_wrapper<"setrandshard"_n, &orng::setrandshard>;
+
+    /**
+     * Gets the next jobs of a shard, in the same order as getnextjobs. It
+     * does not modify any table.
+     *
+     * @param shard The shard of the jobs
+     * @param max_jobs maximum number of jobs returned
+     * @return The jobs in the order they should be fulfilled
+     */
+    [[eosio::action]] std::vector<pending_job> getshardjobs(uint64_t shard, uint64_t max_jobs);
+    using getshardjobs_action = eosio::action_wrapper<"getshardjobs"_n, &orng::getshardjobs>;
+
+    // job waiting for its random value with what the oracle needs to fulfill
+    // it, as returned by getjobfeed
+    struct feed_job {
+        uint64_t    id;
+        uint64_t    signing_value;
+        uint64_t    key_id; // the key to sign with
+        eosio::name caller;
+        eosio::name payer;  // the bandwidth payer of the caller if accepted, empty otherwise
+        bool        derived; // sign signing_value and id, see requestrand
+    };
+
+    struct job_feed {
+        std::vector<feed_job> jobs;
+        uint64_t              cursor; // the cursor of the next page, after the last job returned
+    };
+
+    /**
+     * Gets a page of the jobs waiting for their random value in job id order,
+     * across lanes and shards, with their signing key and bandwidth payer. It
+     * does not modify any table.
+     *
+     * @param cursor The first job id of the page, 0 or the cursor of the previous page
+     * @param max_jobs maximum number of jobs returned
+     * @return The jobs and the cursor of the next page
+     */
+    [[eosio::action]] job_feed getjobfeed(uint64_t cursor, uint64_t max_jobs);
+    using getjobfeed_action = eosio::action_wrapper<"getjobfeed"_n, &orng::getjobfeed>;
+
+    // counters of stats.a and keystats.a, as returned by getstats
+    struct stats_report {
+        uint64_t requested;
+        uint64_t fulfilled;
+        uint64_t killed;
+        uint64_t expired;
+        uint64_t errored;
+        uint64_t depth;     // jobs waiting for their random value
+        uint64_t max_depth; // high-water mark of depth
+        std::vector<uint64_t> latency_histogram; // fulfillments by seconds since the request, see stats_a
+        std::vector<std::pair<uint64_t, uint64_t>> key_signing_values; // signing values kept by key id
+    };
+
+    /**
+     * Gets the job counters, the fulfillment latency histogram and the number
+     * of signing values kept for each key. It does not modify any table.
+     *
+     * @return The counters, the signing values of the active keys are the last ones, slot 0 first
+     */
+    [[eosio::action]] stats_report getstats();
+    using getstats_action = eosio::action_wrapper<"getstats"_n, &orng::getstats>;
+
     /**
      * Sets the public key used by the oracle to sign tx ids. Public keys are
      * stored in their raw RSA exponent and modulus form as hexadecimal integers
@@ -119,10 +375,55 @@ public:
     ACTION setsigpubkey(uint64_t id, const std::string& exponent, const std::string& modulus);
     using setsigpubkey_action = eosio::action_wrapper<"setsigpubkey"_n, &orng::setsigpubkey>;
 
+    /**
+     * Sets several public keys at once, as setsigpubkey does for each of them.
+     *
+     * @param first_id The id of the first key, the next keys get consecutive ids
+     * @param keys Pairs of exponent and modulus
+     */
+    ACTION setpubkeys(uint64_t first_id, const std::vector<std::pair<std::string, std::string>>& keys);
+    using setpubkeys_action = eosio::action_wrapper<"setpubkeys"_n, &orng::setpubkeys>;
+
+    /**
+     * Sets the number of staged keys under which keys_low is raised in
+     * hotstate.a, 1 by default. When the active key runs out and no key is
+     * staged, it keeps signing for chance_to_switch more jobs instead of
+     * failing the requests.
+     *
+     * @param staged_keys minimum number of keys set after the active one
+     */
+    ACTION setlowmark(uint64_t staged_keys);
+    using setlowmark_action = eosio::action_wrapper<"setlowmark"_n, &orng::setlowmark>;
+
+    /**
+     * Sets the number of keys active at once. The next jobs are signed by the
+     * key of slot job_id % slots, each slot rotating to the next staged key on
+     * its own after chance_to_switch of its jobs, so each key can be held by a
+     * different signer. Added slots take staged keys right away, the keys of
+     * removed slots are retired, and the kept slots spread the jobs left to
+     * their keys over the new number of slots. The jobs in flight keep the key
+     * recorded in jobs.a.
+     *
+     * @param slots number of active keys, between 1 and 8
+     */
+    ACTION setkeyslots(uint64_t slots);
+    using setkeyslots_action = eosio::action_wrapper<"setkeyslots"_n, &orng::setkeyslots>;
+
+    /**
+     * Moves public keys from the deprecated sigpubkey.b table, where they are
+     * stored as hex strings, into sigpubkey.c, where they are stored as raw bytes.
+     * It is allowed while the contract is paused so keys can be migrated right
+     * after deploying and before resuming, call it until sigpubkey.b is empty.
+     *
+     * @param rows_num The maximum number of keys to be migrated
+     */
+    ACTION migratekeys(uint64_t rows_num);
+    using migratekeys_action = eosio::action_wrapper<"migratekeys"_n, &orng::migratekeys>;
+
     /**
     * @dev clean the signing values from dapp which has been signed with no longer used public-key.
     * @param scope the scope of table.
-    * @param rows_num The number of rows that be expected to be removed
+    * @param rows_num The number of rows that be expected to be removed, bucket rows for keys using signbucket.a
     * @note it does not allow to removing the signing values which have scope is the id of active public-key
     * @note it also removes signing values that were saved under self scope which are inserted to support v1 rng dependant contracts
     */
@@ -132,11 +433,36 @@ public:
     ACTION setchance(uint64_t chance_to_switch);
     using setchance_action = eosio::action_wrapper<"setchance"_n, &orng::setchance>;
 
+    /**
+     * Stores the signing values of the keys from the given id onwards in
+     * signbucket.a, which packs them in rows by bucket, instead of one row per
+     * value in signvals.a. A key keeps its layout once it signs jobs, so it is
+     * only allowed before any key uses buckets, and for keys that are not active yet.
+     *
+     * @param from_key_id The id of the first key using buckets
+     * @note a bucket row is shared by every dapp, the last dapp adding a value to it pays for the whole row
+     */
+    ACTION setbucketed(uint64_t from_key_id);
+    using setbucketed_action = eosio::action_wrapper<"setbucketed"_n, &orng::setbucketed>;
+
+    /**
+     * Sets how many signing value rows of retired keys are erased by each
+     * request and fulfillment action. The keys are collected in id order and
+     * the cursor is kept in hotstate.a as gc_key_id.
+     *
+     * @param rows_per_call The number of rows erased per action, zero disables it
+     * @note unlike cleansigvals, it leaves the legacy v1 rows to purgev1vals
+     */
+    ACTION setgcrows(uint64_t rows_per_call);
+    using setgcrows_action = eosio::action_wrapper<"setgcrows"_n, &orng::setgcrows>;
+
     /**
     * log the error occur when setrand for dapp
     * @param dapp account name of dapp
     * @param message error message
     * @param assoc_id assoc_id that error happen
+    * @note the log is a ring buffer, the error overwrites the oldest slot and messages are truncated to errmsg.max
+    * @note stats.a counts the job as errored once, however many errors are reported for it
     */
     ACTION dapperror(uint64_t job_id, const std::string message);
     using dapperror_action = eosio::action_wrapper<"dapperror"_n, &orng::dapperror>;
@@ -145,10 +471,39 @@ public:
     * adjusts the number of errors we hold per dapp in the queue before rotating out the oldest one
     * @param dapp account name of dapp
     * @param queue_size number of error message store in table
+    * @note rows left beyond a smaller size are erased one per logged error
     */
     ACTION seterrorsize(const eosio::name& dapp, uint64_t queue_size);
     using seterrorqsize_action = eosio::action_wrapper<"seterrorsize"_n, &orng::seterrorsize>;
 
+    /**
+    * switches a dapp to pull mode: its random values are stored in a ring of
+    * pullres.a rows under the dapp scope instead of being sent to receiverand,
+    * and the dapp is notified of the fulfilling action. The rows are created
+    * now, paid by the dapp.
+    * @param dapp account name of dapp
+    * @param ring_size number of results kept until claimed, up to 256, zero goes back to receiverand
+    * @note the results must all be claimed before changing the size, the oldest ones are overwritten when the ring is full
+    */
+    ACTION setpullmode(const eosio::name& dapp, uint32_t ring_size);
+    using setpullmode_action = eosio::action_wrapper<"setpullmode"_n, &orng::setpullmode>;
+
+    /**
+    * frees the oldest results of the ring of a dapp in pull mode, once read
+    * from pullres.a, from the pull.tail sequence of dappconfig.a
+    * @param dapp account name of dapp
+    * @param count number of results claimed
+    */
+    ACTION claimrand(const eosio::name& dapp, uint64_t count);
+    using claimrand_action = eosio::action_wrapper<"claimrand"_n, &orng::claimrand>;
+
+    /**
+    * sets the maximum length of the error messages, longer messages are truncated
+    * @param max_length maximum number of bytes of a message
+    */
+    ACTION seterrmsgmax(uint64_t max_length);
+    using seterrmsgmax_action = eosio::action_wrapper<"seterrmsgmax"_n, &orng::seterrmsgmax>;
+
 // Implementation
 private:
     TABLE config_a {
@@ -170,15 +525,104 @@ private:
     using sigpubconfig_table_type = eosio::singleton<"pubconfig.a"_n, sigpubkey_config>;
     using sigpubconfig_table_type_abi = eosio::multi_index<"pubconfig.a"_n, sigpubkey_config>; // generate abi file
 
+    // active key of a slot above 0, see setkeyslots
+    struct key_slot {
+        uint64_t key_id = 0;
+        uint64_t pubkey_hash_id = 0;
+        uint64_t last = 0;           // the last job id of the slot signed by the key
+        bool     bucketed = false;
+        uint64_t signing_values = 0; // signing values kept for the key, moved to keystats.a on rotation
+    };
+
+    // State read by every request and fulfillment, packed in a single row so an
+    // action reads it once and writes it once at most. The key fields are the
+    // active key of slot 0, mirrored from its sigpubkey.c row, which is only read
+    // on rotation. pubconfig.a active_key_index is the highest key taken by any
+    // slot, the one the next rotation of a slot moves past.
+    TABLE hotstate_a {
+        bool     paused = false;
+        bool     paused_request = false;
+        uint64_t next_job_id = 0;
+        uint64_t active_key_index = 0;
+        uint64_t active_pubkey_hash_id = 0;
+        uint64_t active_last = 0;  // the last job id signed by the active key
+        bool     active_bucketed = false; // the active key stores its signing values in signbucket.a
+        uint64_t gc_key_id = 0;           // the retired key whose signing values are being collected
+        uint64_t gc_rows_per_call = 0;    // signing value rows erased per action
+        bool     keys_low = false;        // less keys staged than the low watermark, the active key may have been extended
+        uint64_t job_shards = 1;          // jobs from shards_from are in the scopes of shard job_id % job_shards
+        uint64_t prev_job_shards = 1;     // shards of the jobs before shards_from
+        uint64_t shards_from = 0;
+        uint64_t key_slots = 1;           // the jobs are signed by the active key of slot job_id % key_slots
+        std::vector<key_slot> extra_key_slots; // slots from 1, slot 0 is the active key above
+    };
+    using hotstate_table_type = eosio::singleton<"hotstate.a"_n, hotstate_a>;
+    using hotstate_table_type_abi = eosio::multi_index<"hotstate.a"_n, hotstate_a>; // generate abi file
+
+    // scope by lane and shard, self for the free lane and lane.paid for the
+    // paid lane, the shard in the 13th character of the name
     TABLE jobs_a {
         uint64_t    id;
         uint64_t    assoc_id;
         uint64_t    signing_value;
         eosio::name caller;
+        uint32_t    count = 1; // number of random values derived from the signature
+        eosio::time_point_sec created; // block time of the request
+        bool        derived = false; // signing value derived by the contract, signed along with the id
+        uint64_t    key_id = 0;      // the key signing the job
+        bool        errored = false; // reported by dapperror, counted once in stats.a
+
+        auto primary_key() const { return id; }
+        uint128_t by_caller() const { return (uint128_t(caller.value) << 64) | id; } // jobs of a dapp in id order
+    };
+    using jobs_table_type = eosio::multi_index<"jobs.a"_n, jobs_a,
+                                eosio::indexed_by<"bycaller"_n, eosio::const_mem_fun<jobs_a, uint128_t, &jobs_a::by_caller>>>;
+
+    // Counters updated along with the jobs, written once per action at most
+    TABLE stats_a {
+        uint64_t requested = 0;
+        uint64_t fulfilled = 0;
+        uint64_t killed = 0;
+        uint64_t expired = 0;
+        uint64_t errored = 0;
+        uint64_t depth = 0;
+        uint64_t max_depth = 0;
+        uint64_t active_signing_values = 0; // signing values kept for the active key, moved to keystats.a on rotation
+        // fulfillments by latency, bucket 0 is under 1 second, bucket i in
+        // [2^(i-1), 2^i) seconds and the last one takes any longer latency
+        std::vector<uint64_t> latency_histogram;
+    };
+    using stats_table_type = eosio::singleton<"stats.a"_n, stats_a>;
+    using stats_table_type_abi = eosio::multi_index<"stats.a"_n, stats_a>; // generate abi file
+
+    // signing values kept for the keys retired since the counters exist
+    TABLE keystats_a {
+        uint64_t key_id;
+        uint64_t signing_values;
+
+        auto primary_key() const { return key_id; }
+    };
+    using keystats_table_type = eosio::multi_index<"keystats.a"_n, keystats_a>;
+
+    // standing streams of random values, the next_seq replaces the signing
+    // value rows: the signed message, stream id, seq and seed as little-endian
+    // uint64, never repeats since stream ids are not reused
+    TABLE streams_a {
+        uint64_t              id;
+        eosio::name           caller;
+        uint64_t              assoc_id;
+        uint64_t              seed;
+        uint32_t              period;
+        uint32_t              max_outstanding;
+        uint64_t              key_id;   // the key signing the next value, the active key when the last one was set
+        uint64_t              next_seq;
+        eosio::time_point_sec next_due;
 
         auto primary_key() const { return id; }
+        uint64_t by_due() const { return next_due.sec_since_epoch(); }
     };
-    using jobs_table_type = eosio::multi_index<"jobs.a"_n, jobs_a>;
+    using streams_table_type = eosio::multi_index<"streams.a"_n, streams_a,
+                                eosio::indexed_by<"bydue"_n, eosio::const_mem_fun<streams_a, uint64_t, &streams_a::by_due>>>;
 
     // scope by public_key hash
     TABLE signvals_a {
@@ -188,6 +632,15 @@ private:
     };
     using signvals_table_type = eosio::multi_index<"signvals.a"_n, signvals_a>;
 
+    // scope by public_key hash, signing values grouped by the high bits of their mixed value
+    TABLE signbucket_a {
+        uint64_t              bucket;
+        std::vector<uint64_t> signing_values; // sorted
+
+        auto primary_key() const { return bucket; }
+    };
+    using signbucket_table_type = eosio::multi_index<"signbucket.a"_n, signbucket_a>;
+
     // deprecated table
     TABLE sigpubkey_a {
         uint64_t    id;
@@ -198,6 +651,7 @@ private:
     };
     using sigpubkey_table_type_depracated = eosio::multi_index<"sigpubkey.a"_n, sigpubkey_a>;
 
+    // deprecated table, its keys are moved to sigpubkey.c by migratekeys
     TABLE sigpubkey_b {
         uint64_t    id;
         uint64_t    pubkey_hash_id;
@@ -209,10 +663,39 @@ private:
         uint64_t by_hash_id() const { return pubkey_hash_id; }
         uint64_t by_last() const { return last; }
     };
-    using sigpubkey_table_type = eosio::multi_index<"sigpubkey.b"_n, sigpubkey_b,
+    using sigpubkey_table_type_v2 = eosio::multi_index<"sigpubkey.b"_n, sigpubkey_b,
                                 eosio::indexed_by<"byhashid"_n, eosio::const_mem_fun<sigpubkey_b, uint64_t, &sigpubkey_b::by_hash_id>>,
                                 eosio::indexed_by<"bylast"_n, eosio::const_mem_fun<sigpubkey_b, uint64_t, &sigpubkey_b::by_last>>>;
 
+    // exponent and modulus are big-endian integers, half the size of their hex form
+    TABLE sigpubkey_c {
+        uint64_t          id;
+        uint64_t          pubkey_hash_id; // hash of the hex modulus, as in sigpubkey.b
+        std::vector<char> exponent;
+        std::vector<char> modulus;
+        uint64_t          last = 0; // the last job id uses that key
+
+        auto primary_key() const { return id; }
+        uint64_t by_hash_id() const { return pubkey_hash_id; }
+    };
+    using sigpubkey_table_type = eosio::multi_index<"sigpubkey.c"_n, sigpubkey_c,
+                                eosio::indexed_by<"byhashid"_n, eosio::const_mem_fun<sigpubkey_c, uint64_t, &sigpubkey_c::by_hash_id>>>;
+
+    // hex form of a public key, the one verify_rsa_sha256_sig expects
+    struct rsa_public_key {
+        std::string exponent;
+        std::string modulus;
+    };
+
+    // fields of the active key of a slot, in hotstate_a and stats_a for slot 0
+    struct key_slot_ref {
+        uint64_t& key_id;
+        uint64_t& pubkey_hash_id;
+        uint64_t& last;
+        bool&     bucketed;
+        uint64_t& signing_values;
+    };
+
     TABLE bwpayers_a {
         eosio::name payee;
         eosio::name payer;
@@ -222,6 +705,7 @@ private:
     };
     using bwpayers_table_type = eosio::multi_index<"bwpayers.a"_n, bwpayers_a>;
 
+    // scope by dapp, the id is the slot of the ring buffer
     TABLE errorlog_a {
         uint64_t    id;
         eosio::name dapp;
@@ -232,23 +716,84 @@ private:
     };
     using errorlog_table_type = eosio::multi_index<"errorlog.a"_n, errorlog_a>;
 
+    // scope by dapp, the id is the slot of the ring buffer, seq % size
+    TABLE pullres_a {
+        uint64_t             id;
+        uint64_t             seq = 0;   // position of the result, pull.tail to pull.head in dappconfig.a are pending
+        uint64_t             assoc_id = 0;
+        uint32_t             index = 0; // the value of the job, for jobs of several values
+        eosio::checksum256   random_value;
+
+        auto primary_key() const { return id; }
+    };
+    using pullres_table_type = eosio::multi_index<"pullres.a"_n, pullres_a>;
+
     config_table_type       config_table;
     jobs_table_type         jobs_table;
+    jobs_table_type         paid_jobs_table;
     sigpubkey_table_type    sigpubkey_table;
     sigpubconfig_table_type sigpubconfig_table;
     bwpayers_table_type     bwpayers_table;
     signvals_table_type     signvals_table_v1_support;
     sigpubkey_table_type_depracated sigpubkey_table_v1;
+    sigpubkey_table_type_v2 sigpubkey_table_v2;
+    hotstate_table_type     hotstate_table;
+    std::optional<hotstate_a> hotstate_cache;
+    stats_table_type        stats_table;
+    keystats_table_type     keystats_table;
+    streams_table_type      streams_table;
+    std::optional<stats_a>  stats_cache;
+    std::map<uint64_t, jobs_table_type> shard_tables; // lanes of the shards above 0, by scope
 
     // Helpers
-    bool is_paused() const;
-    bool is_paused_request() const;
+    hotstate_a& get_hotstate();
+    void save_hotstate();
+    stats_a& get_stats();
+    void save_stats();
+    void add_requested_jobs(uint64_t count);
+    void forget_signing_values(uint64_t key_id, uint64_t count);
+    static size_t latency_bucket(uint32_t seconds);
+    bool is_paused();
+    bool is_paused_request();
     void set_config(uint64_t name, int64_t value);
     int64_t get_config(uint64_t name, int64_t default_value) const;
     int64_t get_dapp_config(eosio::name dapp, uint64_t name, int64_t default_value) const;
-    uint64_t generate_next_index();
+    void set_dapp_config(eosio::name dapp, uint64_t name, int64_t value, eosio::name payer);
+    bool is_v1_compat(eosio::name dapp) const;
+    jobs_table_type& job_lane(uint64_t job_id);
+    jobs_table_type& lane_table(bool paid, uint64_t shard);
+    uint64_t lane_shards();
+    std::vector<jobs_table_type*> all_lanes();
+    // a lane and its next job, lowest_lane_head picks the lowest job id among them
+    using lane_head = std::pair<jobs_table_type*, jobs_table_type::const_iterator>;
+    static lane_head* lowest_lane_head(std::vector<lane_head>& heads);
+    uint64_t job_shard(uint64_t job_id);
+    void fulfill_results(const std::vector<std::pair<uint64_t, std::string>>& results, std::optional<uint64_t> shard);
+    std::vector<pending_job> next_jobs(std::vector<lane_head>& paid_heads, std::vector<lane_head>& free_heads, uint64_t max_jobs) const;
+    bool is_paid_lane(eosio::name caller) const;
+    void add_inflight(eosio::name dapp, uint64_t count);
+    void release_inflight(eosio::name dapp);
+    uint64_t generate_next_index(uint64_t count = 1);
     uint64_t hash_to_int(const eosio::checksum256& value);
     uint64_t update_current_public_key(uint64_t job_id);
+    key_slot_ref key_slot_of(uint64_t slot);
+    static uint64_t first_slot_job(uint64_t job_id, uint64_t slot, uint64_t slots);
+    bool is_active_key(uint64_t key_id);
+    uint64_t lowest_active_key();
     uint64_t get_current_public_key();
+    void register_public_key(uint64_t id, const std::string& exponent, const std::string& modulus);
+    void update_keys_low(const sigpubkey_config& pubconfig);
+    bool is_bucketed_key(uint64_t key_id) const;
+    void use_signing_value(uint64_t signing_value, const eosio::name& payer, const key_slot_ref& key);
+    uint64_t derive_signing_value(uint64_t job_id, uint64_t pubkey_hash_id);
+    bool is_signing_value_used(uint64_t signing_value);
+    uint64_t erase_signing_values(uint64_t scope, bool bucketed, uint64_t rows_num, bool erase_v1, uint64_t& values_erased);
+    bool collect_signing_values();
+    static uint64_t signing_value_bucket(uint64_t signing_value);
+    void store_pull_results(eosio::name dapp, uint64_t ring_size, uint64_t assoc_id, const std::vector<eosio::checksum256>& random_values);
+    void fulfill_job(jobs_table_type& lane, jobs_table_type::const_iterator job_it, const rsa_public_key& key, const std::string& random_value);
+    static rsa_public_key to_rsa_public_key(const sigpubkey_c& key);
+    static std::vector<char> hex_to_bytes(const std::string& hex);
+    static std::string bytes_to_hex(const std::vector<char>& bytes);
 
 }; // CONTRACT orng
@@ -0,0 +1,218 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Helpers for the dapps receiving random values from orng.wax. They only use
+// the stack, so handling a random value costs no heap allocation.
+//
+//   CONTRACT mydapp : public orng_client::receiver<mydapp> {
+//   public:
+//       using receiver::receiver;
+//
+//       ACTION receiverand(uint64_t assoc_id, const eosio::checksum256& random_value) {
+//           deliver(assoc_id, random_value);
+//       }
+//
+//       void on_random(uint64_t assoc_id, const eosio::checksum256& random_value) {
+//           orng_client::random_stream rng(random_value);
+//           uint64_t card = rng.bounded(52);
+//           ...
+//       }
+//   };
+
+#pragma once
+
+#include <eosio/crypto.hpp>
+#include <eosio/eosio.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace orng_client {
+
+/**
+ * Stream of 64 bits words drawn from a random value. The first four words are
+ * the random value itself, read as big-endian integers, the next ones come in
+ * blocks of four from sha256(random_value || n), n being a big-endian uint32
+ * starting at 0. The same random value always gives the same stream, so
+ * anybody can check the outcome off-chain.
+ */
+class random_stream {
+public:
+    explicit random_stream(const eosio::checksum256& random_value)
+        : _seed(random_value.extract_as_byte_array())
+        , _block(_seed) {
+    }
+
+    uint64_t next() {
+        if (_word == words_per_block) {
+            refill();
+        }
+        return read_word(_block, _word++);
+    }
+
+    /**
+     * Uniform integer in [0, bound). Words below 2^64 mod bound are drawn
+     * again, so every value is equally likely.
+     */
+    uint64_t bounded(uint64_t bound) {
+        eosio::check(bound > 0, "bound must be positive");
+        const uint64_t threshold = (0 - bound) % bound;
+        uint64_t word = next();
+        while (word < threshold) {
+            word = next();
+        }
+        return word % bound;
+    }
+
+    /**
+     * Uniform integer in [low, high]
+     */
+    uint64_t between(uint64_t low, uint64_t high) {
+        eosio::check(low <= high, "low must not be greater than high");
+        if (high - low == std::numeric_limits<uint64_t>::max()) {
+            return next();
+        }
+        return low + bounded(high - low + 1);
+    }
+
+    /**
+     * Sum of rolling the given number of dice with the given number of sides
+     */
+    uint64_t roll(uint32_t sides, uint32_t dice = 1) {
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < dice; ++i) {
+            total += 1 + bounded(sides);
+        }
+        return total;
+    }
+
+    /**
+     * Fisher-Yates shuffle of [first, last)
+     */
+    template <typename RandomIt>
+    void shuffle(RandomIt first, RandomIt last) {
+        const auto size = static_cast<uint64_t>(std::distance(first, last));
+        for (uint64_t i = size; i > 1; --i) {
+            std::iter_swap(first + (i - 1), first + bounded(i));
+        }
+    }
+
+    /**
+     * Index of the weight picked in [first, last), each with a chance
+     * proportional to its weight
+     */
+    template <typename InputIt>
+    size_t pick_weighted(InputIt first, InputIt last) {
+        uint64_t total = 0;
+        for (auto it = first; it != last; ++it) {
+            total += *it;
+        }
+        eosio::check(total > 0, "weights must not all be zero");
+
+        uint64_t target = bounded(total);
+        size_t index = 0;
+        for (auto it = first; it != last; ++it, ++index) {
+            if (target < *it) {
+                break;
+            }
+            target -= *it;
+        }
+        return index;
+    }
+
+    static constexpr uint64_t read_word(const std::array<uint8_t, 32>& bytes, size_t word) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+            value = (value << 8) | bytes[word * sizeof(uint64_t) + i];
+        }
+        return value;
+    }
+
+private:
+    static constexpr size_t words_per_block = 4;
+
+    void refill() {
+        std::array<char, 36> buffer{};
+        for (size_t i = 0; i < _seed.size(); ++i) {
+            buffer[i] = static_cast<char>(_seed[i]);
+        }
+        for (size_t i = 0; i < sizeof(uint32_t); ++i) {
+            buffer[_seed.size() + i] = static_cast<char>(_counter >> (8 * (3 - i)));
+        }
+        _block = eosio::sha256(buffer.data(), buffer.size()).extract_as_byte_array();
+        _word = 0;
+        ++_counter;
+    }
+
+    std::array<uint8_t, 32> _seed;
+    std::array<uint8_t, 32> _block;
+    size_t   _word = 0;
+    uint32_t _counter = 0;
+};
+
+/**
+ * Base of a dapp contract receiving random values. The dapp declares the
+ * receiverand and receiverands actions and calls deliver from them, since the
+ * dispatcher instantiates the class that declares the action. deliver checks
+ * that the value comes from the orng contract and calls
+ *
+ *   void Derived::on_random(uint64_t assoc_id, const eosio::checksum256& random_value);
+ *
+ * once per random value. Derived can also define on_random_values to handle
+ * the values of a receiverands callback together.
+ *
+ * @tparam Orng account of the orng contract
+ */
+template <typename Derived, eosio::name::raw Orng = "orng.wax"_n>
+class receiver : public eosio::contract {
+public:
+    using eosio::contract::contract;
+
+    static constexpr eosio::name orng_account = eosio::name(Orng);
+
+    void on_random_values(uint64_t assoc_id, const std::vector<eosio::checksum256>& random_values) {
+        for (const auto& random_value : random_values) {
+            derived().on_random(assoc_id, random_value);
+        }
+    }
+
+protected:
+    void deliver(uint64_t assoc_id, const eosio::checksum256& random_value) {
+        eosio::require_auth(orng_account);
+        derived().on_random(assoc_id, random_value);
+    }
+
+    void deliver(uint64_t assoc_id, const std::vector<eosio::checksum256>& random_values) {
+        eosio::require_auth(orng_account);
+        derived().on_random_values(assoc_id, random_values);
+    }
+
+private:
+    Derived& derived() { return static_cast<Derived&>(*this); }
+};
+
+} // namespace orng_client
@@ -26,16 +26,50 @@
 #include <eosio/check.hpp>
 #include <eosio/crypto.hpp>
 #include <eosio/print.hpp>
+#include <eosio/system.hpp>
+#include <eosio/transaction.hpp>
 
+#include <limits>
+#include <map>
 #include <tuple>
 
 using namespace eosio;
 using std::string;
 
-static constexpr uint64_t paused_request_row            = "pauserequest"_n.value; // pause only requestrand action
-static constexpr uint64_t paused_index                  = "paused"_n.value;       // pause all actions except pause
-static constexpr uint64_t jobid_index                   = "jobid.index"_n.value;  // next job id row
+static constexpr uint64_t paused_request_row            = "pauserequest"_n.value; // legacy row, moved to hotstate.a
+static constexpr uint64_t paused_index                  = "paused"_n.value;       // legacy row, moved to hotstate.a
+static constexpr uint64_t jobid_index                   = "jobid.index"_n.value;  // legacy row, moved to hotstate.a
 static constexpr uint64_t dapp_error_log_size_index     = "erorrlogsize"_n.value;  // maximum number of error messages log in table
+static constexpr uint64_t dapp_error_log_head_index     = "errorlog.hd"_n.value;  // number of error messages logged, the next slot is head % size
+static constexpr uint64_t error_message_max_index       = "errmsg.max"_n.value;   // maximum length of an error message
+static constexpr int64_t  default_error_message_max     = 256;
+static constexpr uint32_t max_random_values_count       = 256;                    // random values derived from one signature
+static constexpr uint64_t dapp_v1_compat_index          = "v1compat"_n.value;     // record signing values under self scope for the dapp
+static constexpr uint64_t v1_purge_cursor_index         = "v1purge.cur"_n.value;  // next signing value checked by purgev1vals
+static constexpr uint64_t bucketed_key_index            = "bucketed.key"_n.value; // first key storing its signing values in signbucket.a
+static constexpr uint64_t signing_value_bucket_bits     = 12;                     // 4096 bucket rows per key
+static constexpr uint64_t derived_signing_value         = 0;                      // requested signing value asking the contract to derive one
+static constexpr uint64_t dapp_inflight_index           = "inflight"_n.value;     // jobs of the dapp waiting for their random value
+static constexpr uint64_t dapp_max_inflight_index       = "maxinflight"_n.value;  // maximum jobs of the dapp in flight, no limit if not set
+static constexpr uint64_t paid_lane_scope               = "lane.paid"_n.value;    // jobs scope of the dapps whose bandwidth payer accepted
+static constexpr uint64_t paid_lane_weight_index        = "lane.weight"_n.value;  // paid jobs served for every free job
+static constexpr int64_t  default_paid_lane_weight      = 4;
+static constexpr uint64_t key_low_watermark_index       = "key.lowmark"_n.value;  // staged keys under which keys_low is raised
+static constexpr int64_t  default_key_low_watermark     = 1;
+static constexpr uint64_t max_job_shards                = 16;                     // the shard is stored in the 13th character of the jobs scope
+static constexpr uint64_t max_key_slots                 = 8;                      // keys active at once, kept in hotstate.a
+static constexpr uint64_t next_stream_id_index          = "stream.next"_n.value;  // id of the next stream, never reused
+static constexpr uint32_t max_stream_outstanding        = 256;
+static constexpr uint64_t dapp_streams_index            = "streams"_n.value;      // open streams of the dapp
+static constexpr uint64_t max_streams_index             = "stream.max"_n.value;   // open streams allowed per dapp
+static constexpr int64_t  default_max_streams           = 4;
+static constexpr uint64_t stream_min_period_index       = "stream.minp"_n.value;  // shortest period of a new stream in seconds
+static constexpr int64_t  default_stream_min_period     = 5;
+static constexpr uint64_t dapp_pull_size_index          = "pull.size"_n.value;    // size of the results ring of a dapp in pull mode
+static constexpr uint64_t dapp_pull_head_index          = "pull.head"_n.value;    // results stored, the next slot is head % size
+static constexpr uint64_t dapp_pull_tail_index          = "pull.tail"_n.value;    // results claimed
+static constexpr uint32_t max_pull_ring_size            = 256;
+static constexpr size_t   latency_buckets               = 16;                     // the last one takes latencies from 2^14 seconds
 const name v1_ram_account                               = "oraclev1.wax"_n;
 
 orng::orng(const name& receiver,
@@ -45,67 +79,123 @@ orng::orng(const name& receiver,
     , config_table(receiver, receiver.value)
     , sigpubconfig_table(receiver, receiver.value)
     , jobs_table(receiver, receiver.value)
+    , paid_jobs_table(receiver, paid_lane_scope)
     , sigpubkey_table(receiver, receiver.value)
     , bwpayers_table(receiver, receiver.value)
     , signvals_table_v1_support(receiver, receiver.value)
-    , sigpubkey_table_v1(receiver, receiver.value) {
+    , sigpubkey_table_v1(receiver, receiver.value)
+    , sigpubkey_table_v2(receiver, receiver.value)
+    , hotstate_table(receiver, receiver.value)
+    , stats_table(receiver, receiver.value)
+    , keystats_table(receiver, receiver.value)
+    , streams_table(receiver, receiver.value) {
 }
 
 ACTION orng::pause(bool paused) {
     require_auth({get_self(), "pause"_n});
-    set_config(paused_index, uint64_t(paused));
+    get_hotstate().paused = paused;
+    save_hotstate();
 }
 
 ACTION orng::pauserequest(bool paused) {
     require_auth({get_self(), "pause"_n});
-    set_config(paused_request_row, uint64_t(paused));
+    get_hotstate().paused_request = paused;
+    save_hotstate();
 }
 
 ACTION orng::dapperror(uint64_t job_id, const std::string message) {
-    auto job_it = jobs_table.find(job_id);
-    check(job_it != jobs_table.end(), "Could not find job id.");
+    auto& lane = job_lane(job_id);
+    auto job_it = lane.find(job_id);
+    check(job_it != lane.end(), "Could not find job id.");
 
     require_auth({job_it->caller, "ornglog"_n});
 
-    errorlog_table_type errorlog_table(get_self(), job_it->caller.value);
-    uint64_t log_id = errorlog_table.available_primary_key();
+    if (!job_it->errored) {
+        lane.modify(job_it, same_payer, [&](auto& rec) {
+            rec.errored = true;
+        });
+        get_stats().errored += 1;
+        save_stats();
+    }
 
+    errorlog_table_type errorlog_table(get_self(), job_it->caller.value);
     uint64_t error_log_size = get_dapp_config(job_it->caller, dapp_error_log_size_index, 0);
 
-    while (
-        errorlog_table.begin() != errorlog_table.end() && 
-        errorlog_table.rbegin()->id - errorlog_table.begin()->id + 1 >= error_log_size
-    ) {
-        errorlog_table.erase(errorlog_table.begin());
+    // rows beyond the size, left by a smaller size or the legacy layout, are trimmed one per error
+    if (errorlog_table.begin() != errorlog_table.end()) {
+        auto last_it = errorlog_table.end();
+        --last_it;
+        if (last_it->id >= error_log_size) {
+            errorlog_table.erase(last_it);
+        }
     }
 
     if (error_log_size == 0) {
         return;
     }
 
-    errorlog_table.emplace(job_it->caller, [&](auto& rec) {
-        rec.id = errorlog_table.available_primary_key();
+    uint64_t head = get_dapp_config(job_it->caller, dapp_error_log_head_index, 0);
+    uint64_t max_length = get_config(error_message_max_index, default_error_message_max);
+    auto write_error = [&](auto& rec) {
+        rec.id = head % error_log_size;
         rec.dapp = job_it->caller;
         rec.assoc_id = job_it->assoc_id;
-        rec.message = message;
-    });
+        rec.message = message.substr(0, max_length);
+    };
+
+    auto slot_it = errorlog_table.find(head % error_log_size);
+    if (slot_it == errorlog_table.end()) {
+        errorlog_table.emplace(job_it->caller, write_error);
+    } else {
+        errorlog_table.modify(slot_it, same_payer, write_error);
+    }
+
+    set_dapp_config(job_it->caller, dapp_error_log_head_index, head + 1, job_it->caller);
 }
 
 ACTION orng::seterrorsize(const eosio::name& dapp, uint64_t queue_size) {
     require_auth(dapp);
+    set_dapp_config(dapp, dapp_error_log_size_index, queue_size, dapp);
+}
 
-    dappconfig_table_type dappconfig_table(get_self(), dapp.value);
-    auto it = dappconfig_table.find(dapp_error_log_size_index);
-    if (it == dappconfig_table.end()) {
-        dappconfig_table.emplace(dapp, [&](auto& rec) {
-            rec.name = dapp_error_log_size_index;
-            rec.value = queue_size;
-        });
-    } else {
-        dappconfig_table.modify(it, same_payer, [&](auto& rec) {
-            rec.value = queue_size;
-        });
+ACTION orng::setpullmode(const eosio::name& dapp, uint32_t ring_size) {
+    require_auth(dapp);
+    check(ring_size <= max_pull_ring_size, "ring_size must be at most 256");
+
+    const uint64_t head = get_dapp_config(dapp, dapp_pull_head_index, 0);
+    const uint64_t tail = get_dapp_config(dapp, dapp_pull_tail_index, 0);
+    check(head == tail, "claim the pending results first");
+
+    // every row exists before fulfillment, which only modifies them
+    pullres_table_type pullres_table(get_self(), dapp.value);
+    for (uint64_t slot = 0; slot < ring_size; ++slot) {
+        if (pullres_table.find(slot) == pullres_table.end()) {
+            pullres_table.emplace(dapp, [&](auto& rec) {
+                rec.id = slot;
+            });
+        }
+    }
+    for (auto it = pullres_table.lower_bound(ring_size); it != pullres_table.end();) {
+        it = pullres_table.erase(it);
     }
+
+    set_dapp_config(dapp, dapp_pull_size_index, ring_size, dapp);
+    set_dapp_config(dapp, dapp_pull_head_index, head, dapp);
+    set_dapp_config(dapp, dapp_pull_tail_index, tail, dapp);
+}
+
+ACTION orng::claimrand(const eosio::name& dapp, uint64_t count) {
+    require_auth(dapp);
+
+    const uint64_t head = get_dapp_config(dapp, dapp_pull_head_index, 0);
+    const uint64_t tail = get_dapp_config(dapp, dapp_pull_tail_index, 0);
+    check(count <= head - tail, "count is over the pending results");
+    set_dapp_config(dapp, dapp_pull_tail_index, tail + count, dapp);
+}
+
+ACTION orng::seterrmsgmax(uint64_t max_length) {
+    require_auth("oracle.wax"_n);
+    set_config(error_message_max_index, max_length);
 }
 
 ACTION orng::version() {
@@ -175,80 +265,456 @@ ACTION orng::v1rrcompat(uint64_t signing_value) {
     });
 }
 
+ACTION orng::setv1compat(const eosio::name& dapp, bool enabled) {
+    check(has_auth(dapp) || has_auth(get_self()), "missing authority of " + dapp.to_string());
+    set_dapp_config(dapp, dapp_v1_compat_index, enabled, has_auth(dapp) ? dapp : get_self());
+}
+
+ACTION orng::purgev1vals(uint64_t rows_num) {
+    require_auth("oracle.wax"_n);
+    check(!is_paused(), "Contract is paused");
+
+    // the values still tracked by the active key may be checked by v1 dependant contracts
+    auto itr = signvals_table_v1_support.lower_bound(static_cast<uint64_t>(get_config(v1_purge_cursor_index, 0)));
+    while (itr != signvals_table_v1_support.end() && rows_num > 0) {
+        if (!is_signing_value_used(itr->signing_value)) {
+            itr = signvals_table_v1_support.erase(itr);
+        } else {
+            ++itr;
+        }
+        --rows_num;
+    }
+
+    set_config(v1_purge_cursor_index, itr == signvals_table_v1_support.end() ? 0 : itr->signing_value);
+}
+
 ACTION orng::requestrand(uint64_t assoc_id,
                          uint64_t signing_value,
-                         const name& caller) {
+                         const name& caller,
+                         const binary_extension<uint32_t>& count) {
     check(!is_paused(), "Contract is paused");
     check(!is_paused_request(), "Orng.wax are under maintenance, please try again later");
 
     require_auth(caller);
+    const uint32_t values_count = count.value_or(1);
+    check(values_count >= 1 && values_count <= max_random_values_count, "count must be between 1 and 256");
+    add_inflight(caller, 1);
     auto next_job_id = generate_next_index();
-    auto current_active_key = update_current_public_key(next_job_id);
-    signvals_table_type signvals_table_by_scope(get_self(), current_active_key);
-    auto it = signvals_table_by_scope.find(signing_value);
-    check(it == signvals_table_by_scope.end(), "Signing value already used");
-
-    signvals_table_by_scope.emplace(caller, [&](auto& rec) {
-        rec.signing_value = signing_value;
-    });
+    const auto key = key_slot_of(update_current_public_key(next_job_id));
+    const bool derived = signing_value == derived_signing_value;
+    if (derived) {
+        signing_value = derive_signing_value(next_job_id, key.pubkey_hash_id);
+    } else {
+        use_signing_value(signing_value, caller, key);
+    }
 
-    jobs_table.emplace(caller, [&](auto& rec) {
+    auto& lane = lane_table(is_paid_lane(caller), job_shard(next_job_id));
+    lane.emplace(caller, [&](auto& rec) {
         rec.id = next_job_id;
         rec.assoc_id = assoc_id;
         rec.signing_value = signing_value;
         rec.caller = caller;
+        rec.count = values_count;
+        rec.created = current_time_point();
+        rec.derived = derived;
+        rec.key_id = key.key_id;
     });
+    add_requested_jobs(1);
+    collect_signing_values();
+    save_hotstate();
+    save_stats();
 
     // record the signing value in the old way for backwards compatibility with v1 dependant contracts
-    action(
-      {v1_ram_account, "active"_n},
-      get_self(), "v1rrcompat"_n,
-      std::tuple(signing_value))
-      .send();
+    if (!derived && is_v1_compat(caller)) {
+        action(
+          {v1_ram_account, "active"_n},
+          get_self(), "v1rrcompat"_n,
+          std::tuple(signing_value))
+          .send();
+    }
 }
 
-ACTION orng::setrand(uint64_t job_id, const string& random_value) {
-    require_auth("oracle.wax"_n);
+ACTION orng::requestrands(const std::vector<std::pair<uint64_t, uint64_t>>& requests,
+                          const name& caller) {
+    check(!is_paused(), "Contract is paused");
+    check(!is_paused_request(), "Orng.wax are under maintenance, please try again later");
+
+    require_auth(caller);
+    check(!requests.empty(), "requests must not be empty");
+    add_inflight(caller, requests.size());
+
+    // reserve the whole block of job ids with a single counter update
+    auto first_job_id = generate_next_index(requests.size());
+    const bool v1_compat = is_v1_compat(caller);
+    const bool paid = is_paid_lane(caller);
+
+    for (uint64_t i = 0; i < requests.size(); ++i) {
+        const uint64_t job_id = first_job_id + i;
+        uint64_t signing_value = requests[i].second;
+
+        // the block may run past the key of a slot, the remaining jobs of the slot move on to the next one
+        const auto key = key_slot_of(update_current_public_key(job_id));
+
+        const bool derived = signing_value == derived_signing_value;
+        if (derived) {
+            signing_value = derive_signing_value(job_id, key.pubkey_hash_id);
+        } else {
+            use_signing_value(signing_value, caller, key);
+        }
+
+        lane_table(paid, job_shard(job_id)).emplace(caller, [&](auto& rec) {
+            rec.id = job_id;
+            rec.assoc_id = requests[i].first;
+            rec.signing_value = signing_value;
+            rec.caller = caller;
+            rec.created = current_time_point();
+            rec.derived = derived;
+            rec.key_id = key.key_id;
+        });
+
+        if (v1_compat && !derived) {
+            action(
+              {v1_ram_account, "active"_n},
+              get_self(), "v1rrcompat"_n,
+              std::tuple(signing_value))
+              .send();
+        }
+    }
+    add_requested_jobs(requests.size());
+    collect_signing_values();
+    save_hotstate();
+    save_stats();
+}
+
+ACTION orng::subscribe(const name& caller, uint64_t assoc_id, uint32_t period, uint32_t max_outstanding, uint64_t seed) {
     check(!is_paused(), "Contract is paused");
+    check(!is_paused_request(), "Orng.wax are under maintenance, please try again later");
 
-    auto job_it = jobs_table.find(job_id);
-    check(job_it != jobs_table.end(), "Could not find job id.");
+    require_auth(caller);
+    const uint64_t min_period = get_config(stream_min_period_index, default_stream_min_period);
+    check(period >= min_period, "period must be at least " + std::to_string(min_period) + " seconds");
+    check(max_outstanding >= 1 && max_outstanding <= max_stream_outstanding, "max_outstanding must be between 1 and 256");
+    check(sigpubconfig_table.exists(), "admin: no available public-key");
+
+    // every value is a setstreamrnd paid by the oracle, so the streams of a dapp are capped
+    const uint64_t streams = get_dapp_config(caller, dapp_streams_index, 0) + 1;
+    check(streams <= static_cast<uint64_t>(get_config(max_streams_index, default_max_streams)),
+          "too many streams for " + caller.to_string());
+    set_dapp_config(caller, dapp_streams_index, streams, caller);
+
+    const uint64_t stream_id = get_config(next_stream_id_index, 0);
+    set_config(next_stream_id_index, stream_id + 1);
+
+    streams_table.emplace(caller, [&](auto& rec) {
+        rec.id = stream_id;
+        rec.caller = caller;
+        rec.assoc_id = assoc_id;
+        rec.seed = seed;
+        rec.period = period;
+        rec.max_outstanding = max_outstanding;
+        rec.key_id = get_hotstate().active_key_index;
+        rec.next_seq = 0;
+        rec.next_due = current_time_point();
+    });
+}
+
+ACTION orng::unsubscribe(uint64_t stream_id) {
+    auto stream_it = streams_table.require_find(stream_id, "Could not find stream id.");
+    check(has_auth(stream_it->caller) || has_auth("oracle.wax"_n), "missing authority of " + stream_it->caller.to_string());
+
+    const uint64_t streams = get_dapp_config(stream_it->caller, dapp_streams_index, 0);
+    set_dapp_config(stream_it->caller, dapp_streams_index, streams > 0 ? streams - 1 : 0, stream_it->caller);
+    streams_table.erase(stream_it);
+}
 
-    uint64_t sig_val{job_it->signing_value};
+ACTION orng::setstreamcap(uint32_t max_streams, uint32_t min_period) {
+    require_auth("oracle.wax"_n);
+    check(min_period >= 1, "min_period must be at least 1 second");
+    set_config(max_streams_index, max_streams);
+    set_config(stream_min_period_index, min_period);
+}
 
-    std::string exponent;
-    std::string modulus;
+ACTION orng::setstreamrnd(uint64_t stream_id, uint64_t seq, const string& random_value) {
+    require_auth("oracle.wax"_n);
+    check(!is_paused(), "Contract is paused");
 
-    auto bylast_idx = sigpubkey_table.get_index<"bylast"_n>();
-    auto bylast_lowerbound_job_id_itr = bylast_idx.lower_bound(job_id);
-    check(bylast_lowerbound_job_id_itr != bylast_idx.end(), "sanity check: can not find key for job id");
-    exponent = bylast_lowerbound_job_id_itr->exponent;
-    modulus = bylast_lowerbound_job_id_itr->modulus;
+    auto stream_it = streams_table.require_find(stream_id, "Could not find stream id.");
+    check(seq == stream_it->next_seq, "seq must be the next_seq of the stream");
+    const time_point_sec now = current_time_point();
+    check(stream_it->next_due <= now, "stream value not due yet");
 
+    const uint64_t message[] = {stream_it->id, seq, stream_it->seed};
+    const auto key = to_rsa_public_key(sigpubkey_table.get(stream_it->key_id, "Could not find the key of the stream."));
     check(verify_rsa_sha256_sig(
-            &sig_val, sizeof(sig_val), random_value, exponent, modulus),
+            message, sizeof(message), random_value, key.exponent, key.modulus),
             "Could not verify signature.");
 
-    checksum256 rv_hash = sha256(random_value.data(), random_value.size());
+    const checksum256 rv_hash = sha256(random_value.data(), random_value.size());
+    const uint64_t pull_ring_size = get_dapp_config(stream_it->caller, dapp_pull_size_index, 0);
+    if (pull_ring_size > 0) {
+        store_pull_results(stream_it->caller, pull_ring_size, stream_it->assoc_id, {rv_hash});
+    } else {
+        action(
+            {get_self(), "active"_n},
+            stream_it->caller, "receiverand"_n,
+            std::tuple(stream_it->assoc_id, rv_hash))
+            .send();
+    }
+
+    // values missed beyond max_outstanding are skipped, this one counts as due at backlog_start
+    const uint64_t backlog = uint64_t(stream_it->max_outstanding - 1) * stream_it->period;
+    const uint64_t backlog_start = now.sec_since_epoch() > backlog ? now.sec_since_epoch() - backlog : 0;
+    streams_table.modify(stream_it, same_payer, [&](auto& rec) {
+        rec.key_id = get_hotstate().active_key_index;
+        rec.next_seq = seq + 1;
+        rec.next_due = time_point_sec(static_cast<uint32_t>(
+            std::max<uint64_t>(rec.next_due.sec_since_epoch(), backlog_start) + rec.period));
+    });
+}
+
+ACTION orng::setrand(uint64_t job_id, const string& random_value) {
+    require_auth("oracle.wax"_n);
+    check(!is_paused(), "Contract is paused");
+
+    auto& lane = job_lane(job_id);
+    auto job_it = lane.find(job_id);
+    check(job_it != lane.end(), "Could not find job id.");
+
+    const auto key = to_rsa_public_key(sigpubkey_table.get(job_it->key_id, "sanity check"));
+    fulfill_job(lane, job_it, key, random_value);
+
+    if (collect_signing_values()) {
+        save_hotstate();
+    }
+    save_stats();
+}
+
+ACTION orng::setrandbatch(const std::vector<std::pair<uint64_t, string>>& results) {
+    require_auth("oracle.wax"_n);
+    check(!is_paused(), "Contract is paused");
+
+    fulfill_results(results, std::nullopt);
+}
+
+ACTION orng::setrandshard(uint64_t shard, const std::vector<std::pair<uint64_t, string>>& results) {
+    require_auth("oracle.wax"_n);
+    check(!is_paused(), "Contract is paused");
+
+    fulfill_results(results, shard);
+}
+
+ACTION orng::setshards(uint64_t shards) {
+    require_auth("oracle.wax"_n);
+    check(shards >= 1 && shards <= max_job_shards, "shards must be between 1 and 16");
+
+    // only two layouts are tracked, the jobs of the previous one must be gone
+    auto& state = get_hotstate();
+    for (uint64_t shard = 0; shard < state.prev_job_shards; ++shard) {
+        for (bool paid : {false, true}) {
+            auto& lane = lane_table(paid, shard);
+            check(lane.begin() == lane.end() || lane.begin()->id >= state.shards_from,
+                  "jobs of the previous shards must be fulfilled first");
+        }
+    }
 
-    action(
-        {get_self(), "active"_n},
-        job_it->caller, "receiverand"_n,
-        std::tuple(job_it->assoc_id, rv_hash))
-        .send();
+    state.prev_job_shards = state.job_shards;
+    state.job_shards = shards;
+    state.shards_from = state.next_job_id;
+    save_hotstate();
+}
 
-    jobs_table.erase(job_it);
+orng::job_feed orng::getjobfeed(uint64_t cursor, uint64_t max_jobs) {
+    std::vector<lane_head> heads;
+    for (auto* lane : all_lanes()) {
+        heads.emplace_back(lane, lane->lower_bound(cursor));
+    }
+
+    job_feed feed{{}, cursor};
+    std::map<name, name> payers;
+    while (feed.jobs.size() < max_jobs) {
+        auto* next = lowest_lane_head(heads);
+        if (next == nullptr) {
+            break;
+        }
+
+        const auto& job = *next->second;
+        auto payer_it = payers.find(job.caller);
+        if (payer_it == payers.end()) {
+            auto bwpayer_it = bwpayers_table.find(job.caller.value);
+            const bool accepted = bwpayer_it != bwpayers_table.end() && bwpayer_it->accepted;
+            payer_it = payers.emplace(job.caller, accepted ? bwpayer_it->payer : name()).first;
+        }
+
+        feed.jobs.push_back({job.id, job.signing_value, job.key_id, job.caller, payer_it->second, job.derived});
+        feed.cursor = job.id + 1;
+        ++next->second;
+    }
+    return feed;
+}
+
+std::vector<orng::pending_job> orng::getshardjobs(uint64_t shard, uint64_t max_jobs) {
+    check(shard < max_job_shards, "shard must be lower than 16");
+
+    auto& paid_lane = lane_table(true, shard);
+    auto& free_lane = lane_table(false, shard);
+    std::vector<lane_head> paid_heads{{&paid_lane, paid_lane.begin()}};
+    std::vector<lane_head> free_heads{{&free_lane, free_lane.begin()}};
+    return next_jobs(paid_heads, free_heads, max_jobs);
 }
 
 ACTION orng::killjobs(const std::vector<uint64_t>& job_ids) {
     require_auth("oracle.wax"_n);
 
+    auto& stats = get_stats();
     for (const auto& id : job_ids) {
-        auto job_it = jobs_table.find(id);
-        if (job_it != jobs_table.end()) {
-            jobs_table.erase(job_it);
+        auto& lane = job_lane(id);
+        auto job_it = lane.find(id);
+        if (job_it != lane.end()) {
+            release_inflight(job_it->caller);
+            lane.erase(job_it);
+            stats.killed += 1;
+            stats.depth = stats.depth > 0 ? stats.depth - 1 : 0;
+        }
+    }
+    save_stats();
+}
+
+ACTION orng::expirejobs(uint32_t max_age, uint64_t max_rows, bool notify) {
+    require_auth("oracle.wax"_n);
+
+    const time_point_sec expired_before = current_time_point() - seconds(max_age);
+    std::vector<lane_head> heads;
+    for (auto* lane : all_lanes()) {
+        heads.emplace_back(lane, lane->begin());
+    }
+
+    auto& stats = get_stats();
+    for (; max_rows > 0; --max_rows) {
+        auto* head = lowest_lane_head(heads);
+        if (head == nullptr || head->second->created >= expired_before) {
+            break;
+        }
+
+        const auto& job = *head->second;
+        if (notify) {
+            action(
+              {get_self(), "active"_n},
+              get_self(), "jobexpired"_n,
+              std::tuple(job.id, job.assoc_id, job.caller))
+              .send();
+        }
+        release_inflight(job.caller);
+        head->second = head->first->erase(head->second);
+        stats.expired += 1;
+        stats.depth = stats.depth > 0 ? stats.depth - 1 : 0;
+    }
+    save_stats();
+}
+
+ACTION orng::jobexpired([[maybe_unused]] uint64_t job_id, [[maybe_unused]] uint64_t assoc_id, const eosio::name& caller) {
+    require_auth(get_self());
+    require_recipient(caller);
+}
+
+ACTION orng::setinflight(const eosio::name& dapp, uint64_t max_jobs) {
+    require_auth("oracle.wax"_n);
+
+    if (max_jobs > 0) {
+        set_dapp_config(dapp, dapp_max_inflight_index, max_jobs, get_self());
+        return;
+    }
+
+    dappconfig_table_type dappconfig_table(get_self(), dapp.value);
+    auto it = dappconfig_table.find(dapp_max_inflight_index);
+    if (it != dappconfig_table.end()) {
+        dappconfig_table.erase(it);
+    }
+}
+
+std::vector<std::pair<name, uint64_t>> orng::getdepths() {
+    std::map<name, uint64_t> depths;
+
+    // one lookup per dapp, jumping over its jobs to the first job of the next dapp
+    for (auto* lane : all_lanes()) {
+        auto bycaller_idx = lane->get_index<"bycaller"_n>();
+        auto itr = bycaller_idx.begin();
+        while (itr != bycaller_idx.end()) {
+            const name dapp = itr->caller;
+            if (depths.count(dapp) == 0) {
+                depths[dapp] = get_dapp_config(dapp, dapp_inflight_index, 0);
+            }
+            if (dapp.value == std::numeric_limits<uint64_t>::max()) {
+                break;
+            }
+            itr = bycaller_idx.lower_bound(uint128_t(dapp.value + 1) << 64);
+        }
+    }
+    return {depths.begin(), depths.end()};
+}
+
+ACTION orng::setlaneweight(uint64_t paid_weight) {
+    require_auth("oracle.wax"_n);
+    check(paid_weight >= 1, "paid weight must be at least 1");
+    set_config(paid_lane_weight_index, paid_weight);
+}
+
+std::vector<orng::pending_job> orng::getnextjobs(uint64_t max_jobs) {
+    const uint64_t shards = lane_shards();
+
+    std::vector<lane_head> paid_heads;
+    std::vector<lane_head> free_heads;
+    for (uint64_t shard = 0; shard < shards; ++shard) {
+        auto& paid_lane = lane_table(true, shard);
+        auto& free_lane = lane_table(false, shard);
+        paid_heads.emplace_back(&paid_lane, paid_lane.begin());
+        free_heads.emplace_back(&free_lane, free_lane.begin());
+    }
+    return next_jobs(paid_heads, free_heads, max_jobs);
+}
+
+std::vector<orng::pending_job> orng::next_jobs(std::vector<lane_head>& paid_heads, std::vector<lane_head>& free_heads, uint64_t max_jobs) const {
+    const uint64_t paid_weight = get_config(paid_lane_weight_index, default_paid_lane_weight);
+
+    // each lane is the job id order merge of its shards
+    std::vector<pending_job> jobs;
+    auto* paid_head = lowest_lane_head(paid_heads);
+    auto* free_head = lowest_lane_head(free_heads);
+    uint64_t paid_served = 0; // paid jobs taken since the last free job
+    while (jobs.size() < max_jobs && (paid_head != nullptr || free_head != nullptr)) {
+        // an empty lane leaves its turns to the other one
+        const bool take_paid = paid_head != nullptr && (free_head == nullptr || paid_served < paid_weight);
+        if (take_paid) {
+            const auto& job = *paid_head->second;
+            jobs.push_back({job.id, job.signing_value, job.caller, true, job.derived});
+            ++paid_head->second;
+            paid_head = lowest_lane_head(paid_heads);
+            ++paid_served;
+        } else {
+            const auto& job = *free_head->second;
+            jobs.push_back({job.id, job.signing_value, job.caller, false, job.derived});
+            ++free_head->second;
+            free_head = lowest_lane_head(free_heads);
+            paid_served = 0;
         }
     }
+    return jobs;
+}
+
+orng::stats_report orng::getstats() {
+    const auto& stats = get_stats();
+    stats_report report{stats.requested, stats.fulfilled, stats.killed, stats.expired, stats.errored,
+                        stats.depth, stats.max_depth, stats.latency_histogram, {}};
+
+    for (const auto& key : keystats_table) {
+        report.key_signing_values.emplace_back(key.key_id, key.signing_values);
+    }
+    // read without get_hotstate, which creates the row on first use
+    const auto state = hotstate_table.get_or_default();
+    report.key_signing_values.emplace_back(state.active_key_index, stats.active_signing_values);
+    for (const auto& slot : state.extra_key_slots) {
+        report.key_signing_values.emplace_back(slot.key_id, slot.signing_values);
+    }
+    return report;
 }
 
 ACTION orng::setchance(uint64_t chance_to_switch) {
@@ -261,12 +727,124 @@ ACTION orng::setchance(uint64_t chance_to_switch) {
     sigpubconfig_table.set(pubconfig, _self);
 }
 
+ACTION orng::setbucketed(uint64_t from_key_id) {
+    require_auth("oracle.wax"_n);
+    check(!is_paused(), "Contract is paused");
+
+    auto& state = get_hotstate();
+    bool bucketed = state.active_bucketed;
+    for (const auto& slot : state.extra_key_slots) {
+        bucketed = bucketed || slot.bucketed;
+    }
+    check(state.next_job_id == 0 || (!bucketed && from_key_id > sigpubconfig_table.get().active_key_index),
+          "only allow switch the layout of the keys that have not signed jobs");
+
+    set_config(bucketed_key_index, from_key_id);
+    for (uint64_t slot = 0; slot < state.key_slots; ++slot) {
+        const auto key = key_slot_of(slot);
+        key.bucketed = is_bucketed_key(key.key_id);
+    }
+    save_hotstate();
+}
+
+ACTION orng::setgcrows(uint64_t rows_per_call) {
+    require_auth("oracle.wax"_n);
+    check(!is_paused(), "Contract is paused");
+
+    get_hotstate().gc_rows_per_call = rows_per_call;
+    save_hotstate();
+}
+
 ACTION orng::setsigpubkey(uint64_t id,
                           const std::string& exponent,
                           const std::string& modulus) {
     require_auth("oracle.wax"_n);
     check(!is_paused(), "Contract is paused");
 
+    register_public_key(id, exponent, modulus);
+    update_keys_low(sigpubconfig_table.get());
+    save_hotstate();
+}
+
+ACTION orng::setpubkeys(uint64_t first_id,
+                        const std::vector<std::pair<std::string, std::string>>& keys) {
+    require_auth("oracle.wax"_n);
+    check(!is_paused(), "Contract is paused");
+    check(!keys.empty(), "keys must not be empty");
+
+    for (uint64_t i = 0; i < keys.size(); ++i) {
+        register_public_key(first_id + i, keys[i].first, keys[i].second);
+    }
+    update_keys_low(sigpubconfig_table.get());
+    save_hotstate();
+}
+
+ACTION orng::setlowmark(uint64_t staged_keys) {
+    require_auth("oracle.wax"_n);
+    check(!is_paused(), "Contract is paused");
+
+    set_config(key_low_watermark_index, staged_keys);
+    if (sigpubconfig_table.exists()) {
+        update_keys_low(sigpubconfig_table.get());
+        save_hotstate();
+    }
+}
+
+ACTION orng::setkeyslots(uint64_t slots) {
+    require_auth("oracle.wax"_n);
+    check(!is_paused(), "Contract is paused");
+    check(slots >= 1 && slots <= max_key_slots, "slots must be between 1 and 8");
+
+    auto& state = get_hotstate();
+    auto pubconfig = sigpubconfig_table.get();
+
+    // the kept slots spread the jobs left to their keys over the new stride,
+    // so a key still signs chance_to_switch jobs whatever the number of slots
+    const bool started = state.active_last != 0 || state.active_key_index != 0;
+    for (uint64_t slot = started ? 0 : 1; slot < std::min(state.key_slots, slots); ++slot) {
+        const auto key = key_slot_of(slot);
+        const uint64_t first_old = first_slot_job(state.next_job_id, slot, state.key_slots);
+        if (key.last < first_old) {
+            continue; // runs out on the next job of the slot
+        }
+        key.last = first_slot_job(state.next_job_id, slot, slots) + (key.last - first_old) / state.key_slots * slots;
+        auto key_it = sigpubkey_table.require_find(key.key_id, "sanity check");
+        sigpubkey_table.modify(key_it, get_self(), [&](auto& rec) {
+            rec.last = key.last;
+        });
+    }
+
+    // the keys of the removed slots are retired, their signing values collected
+    // as any other, or right away with cleansigvals
+    while (state.key_slots > slots) {
+        const auto& key = state.extra_key_slots.back();
+        keystats_table.emplace(get_self(), [&](auto& rec) {
+            rec.key_id = key.key_id;
+            rec.signing_values = key.signing_values;
+        });
+        state.extra_key_slots.pop_back();
+        state.key_slots -= 1;
+    }
+
+    // the added slots take staged keys, from the first of their jobs not requested yet
+    const uint64_t staged_keys = pubconfig.available_key_counter - pubconfig.active_key_index - 1;
+    check(slots - state.key_slots <= staged_keys, "not enough staged keys for the slots");
+    for (uint64_t slot = state.key_slots; slot < slots; ++slot) {
+        pubconfig.active_key_index += 1;
+        auto key_it = sigpubkey_table.require_find(pubconfig.active_key_index, "sanity check");
+        sigpubkey_table.modify(key_it, get_self(), [&](auto& rec) {
+            rec.last = first_slot_job(state.next_job_id, slot, slots) + (pubconfig.chance_to_switch - 1) * slots;
+        });
+        state.extra_key_slots.push_back({key_it->id, key_it->pubkey_hash_id, key_it->last, is_bucketed_key(key_it->id), 0});
+    }
+    state.key_slots = slots;
+
+    sigpubconfig_table.set(pubconfig, get_self());
+    update_keys_low(pubconfig);
+    save_hotstate();
+}
+
+void orng::register_public_key(uint64_t id, const std::string& exponent, const std::string& modulus) {
     check(modulus.size() > 0, "modulus must have non-zero length");
     check(modulus[0] != '0', "modulus must have leading zeroes stripped");
 
@@ -296,42 +874,138 @@ ACTION orng::setsigpubkey(uint64_t id,
     sigpubkey_table.emplace(get_self(), [&](auto& rec) {
         rec.id = id;
         rec.pubkey_hash_id = pubkey_hash_id;
-        rec.exponent = exponent;
-        rec.modulus = modulus;
+        rec.exponent = hex_to_bytes(exponent);
+        rec.modulus = hex_to_bytes(modulus);
     });
 }
 
+ACTION orng::migratekeys(uint64_t rows_num) {
+    require_auth("oracle.wax"_n);
+
+    auto itr = sigpubkey_table_v2.begin();
+    while (itr != sigpubkey_table_v2.end() && rows_num > 0) {
+        check(sigpubkey_table.find(itr->id) == sigpubkey_table.end(), "key with this id has already exsited");
+        sigpubkey_table.emplace(get_self(), [&](auto& rec) {
+            rec.id = itr->id;
+            rec.pubkey_hash_id = itr->pubkey_hash_id;
+            rec.exponent = hex_to_bytes(itr->exponent);
+            rec.modulus = hex_to_bytes(itr->modulus);
+            rec.last = itr->last;
+        });
+        itr = sigpubkey_table_v2.erase(itr);
+        --rows_num;
+    }
+}
+
 ACTION orng::cleansigvals(uint64_t scope, uint64_t rows_num) {
     require_auth("oracle.wax"_n);
     check(!is_paused(), "Contract is paused");
 
-    if (scope != get_self().value) {
-        auto byhash_idx = sigpubkey_table.get_index<"byhashid"_n>();
-        auto byhash_itr = byhash_idx.require_find(scope, "pubkey_hash_id does not exist");
+    if (scope == get_self().value) {
+        uint64_t values_erased = 0;
+        erase_signing_values(scope, false, rows_num, true, values_erased);
+        return;
+    }
+
+    auto byhash_idx = sigpubkey_table.get_index<"byhashid"_n>();
+    auto byhash_itr = byhash_idx.require_find(scope, "pubkey_hash_id does not exist");
+    auto pubconfig = sigpubconfig_table.get();
+    check(byhash_itr->id <= pubconfig.active_key_index && !is_active_key(byhash_itr->id),
+          "only allow clean the signvals that was singed by old keys");
+
+    uint64_t values_erased = 0;
+    erase_signing_values(scope, is_bucketed_key(byhash_itr->id), rows_num, true, values_erased);
+    forget_signing_values(byhash_itr->id, values_erased);
+}
+
+orng::hotstate_a& orng::get_hotstate() {
+    if (hotstate_cache) {
+        return *hotstate_cache;
+    }
+
+    if (hotstate_table.exists()) {
+        hotstate_cache = hotstate_table.get();
+        return *hotstate_cache;
+    }
+
+    // first use after upgrading, the hot rows are moved out of config.a
+    hotstate_a state;
+    state.paused = get_config(paused_index, false);
+    state.paused_request = get_config(paused_request_row, false);
+    state.next_job_id = get_config(jobid_index, 0);
+    if (sigpubconfig_table.exists()) {
         auto pubconfig = sigpubconfig_table.get();
-        check(byhash_itr->id < pubconfig.active_key_index, "only allow clean the signvals that was singed by old keys");
+        auto it = sigpubkey_table.require_find(pubconfig.active_key_index, "public keys must be migrated first");
+        state.active_key_index = it->id;
+        state.active_pubkey_hash_id = it->pubkey_hash_id;
+        state.active_last = it->last;
+        state.active_bucketed = is_bucketed_key(it->id);
     }
-    signvals_table_type signvals_table_by_scope(get_self(), scope);
 
-    auto itr = signvals_table_by_scope.begin();
-    while (itr != signvals_table_by_scope.end() && rows_num > 0) {
-        auto _itr = itr;
-        itr = signvals_table_by_scope.erase(_itr);
-        auto v1_itr = signvals_table_v1_support.find(_itr->signing_value);
-        if (v1_itr != signvals_table_v1_support.end()) {
-          // the signing value was placed in the table under self scope to support contracts that still require the legacy tracking
-          signvals_table_v1_support.erase(v1_itr);
+    // the dapps of an upgraded contract keep their self scope rows until they opt out
+    if (config_table.find(jobid_index) != config_table.end()) {
+        set_dapp_config(get_self(), dapp_v1_compat_index, true, get_self());
+    }
+
+    for (auto row : {paused_index, paused_request_row, jobid_index}) {
+        auto it = config_table.find(row);
+        if (it != config_table.end()) {
+            config_table.erase(it);
         }
-        --rows_num;
     }
+
+    hotstate_table.set(state, get_self());
+    hotstate_cache = state;
+    return *hotstate_cache;
+}
+
+void orng::save_hotstate() {
+    hotstate_table.set(get_hotstate(), get_self());
+}
+
+orng::stats_a& orng::get_stats() {
+    if (!stats_cache) {
+        stats_cache = stats_table.get_or_default();
+    }
+    return *stats_cache;
+}
+
+void orng::save_stats() {
+    stats_table.set(get_stats(), get_self());
+}
+
+void orng::add_requested_jobs(uint64_t count) {
+    auto& stats = get_stats();
+    stats.requested += count;
+    stats.depth += count;
+    stats.max_depth = std::max(stats.max_depth, stats.depth);
+}
+
+void orng::forget_signing_values(uint64_t key_id, uint64_t count) {
+    // keys retired before the counters existed have no row
+    auto it = keystats_table.find(key_id);
+    if (it != keystats_table.end() && count > 0) {
+        keystats_table.modify(it, same_payer, [&](auto& rec) {
+            rec.signing_values = rec.signing_values > count ? rec.signing_values - count : 0;
+        });
+    }
+}
+
+size_t orng::latency_bucket(uint32_t seconds) {
+    size_t bucket = 0;
+    while (seconds > 0 && bucket + 1 < latency_buckets) {
+        seconds >>= 1;
+        ++bucket;
+    }
+    return bucket;
 }
 
-bool orng::is_paused() const {
-    return get_config(paused_index, false);
+bool orng::is_paused() {
+    return get_hotstate().paused;
 }
 
-bool orng::is_paused_request() const {
-    return get_config(paused_request_row, false);
+bool orng::is_paused_request() {
+    return get_hotstate().paused_request;
 }
 
 void orng::set_config(uint64_t name, int64_t value) {
@@ -364,33 +1038,499 @@ int64_t orng::get_dapp_config(eosio::name dapp, uint64_t name, int64_t default_v
     return it->value;
 }
 
-uint64_t orng::generate_next_index() {
-    int64_t index_val = get_config(jobid_index, 0);
-    set_config(jobid_index, index_val + 1);
+bool orng::is_v1_compat(eosio::name dapp) const {
+    // the v1compat row of the contract itself is the default of the dapps without one
+    return get_dapp_config(dapp, dapp_v1_compat_index, get_dapp_config(get_self(), dapp_v1_compat_index, 0));
+}
+
+void orng::set_dapp_config(eosio::name dapp, uint64_t name, int64_t value, eosio::name payer) {
+    dappconfig_table_type dappconfig_table(get_self(), dapp.value);
+    auto it = dappconfig_table.find(name);
+    if (it == dappconfig_table.end()) {
+        dappconfig_table.emplace(payer, [&](auto& rec) {
+            rec.name = name;
+            rec.value = value;
+        });
+    }
+    else {
+        dappconfig_table.modify(it, same_payer, [&](auto& rec) {
+            rec.value = value;
+        });
+    }
+}
+
+orng::jobs_table_type& orng::job_lane(uint64_t job_id) {
+    // the free lane also holds the jobs requested before the lanes existed
+    const uint64_t shard = job_shard(job_id);
+    auto& paid_lane = lane_table(true, shard);
+    return paid_lane.find(job_id) != paid_lane.end() ? paid_lane : lane_table(false, shard);
+}
+
+orng::jobs_table_type& orng::lane_table(bool paid, uint64_t shard) {
+    if (shard == 0) {
+        return paid ? paid_jobs_table : jobs_table;
+    }
+    // account names are at most 12 characters, leaving the low 4 bits free
+    const uint64_t scope = (paid ? paid_lane_scope : get_self().value) | shard;
+    return shard_tables.try_emplace(scope, get_self(), scope).first->second;
+}
+
+uint64_t orng::lane_shards() {
+    // read without get_hotstate, which creates the row on first use, so the query actions never write
+    const auto state = hotstate_cache ? *hotstate_cache : hotstate_table.get_or_default();
+    return std::max(state.job_shards, state.prev_job_shards);
+}
+
+std::vector<orng::jobs_table_type*> orng::all_lanes() {
+    const uint64_t shards = lane_shards();
+
+    std::vector<jobs_table_type*> lanes;
+    for (uint64_t shard = 0; shard < shards; ++shard) {
+        lanes.push_back(&lane_table(false, shard));
+        lanes.push_back(&lane_table(true, shard));
+    }
+    return lanes;
+}
+
+orng::lane_head* orng::lowest_lane_head(std::vector<lane_head>& heads) {
+    // job ids grow with the request time, so the lowest one is the oldest job
+    lane_head* lowest = nullptr;
+    for (auto& head : heads) {
+        if (head.second != head.first->end() && (lowest == nullptr || head.second->id < lowest->second->id)) {
+            lowest = &head;
+        }
+    }
+    return lowest;
+}
+
+uint64_t orng::job_shard(uint64_t job_id) {
+    const auto& state = get_hotstate();
+    return job_id % (job_id >= state.shards_from ? state.job_shards : state.prev_job_shards);
+}
+
+bool orng::is_paid_lane(eosio::name caller) const {
+    auto it = bwpayers_table.find(caller.value);
+    return it != bwpayers_table.end() && it->accepted;
+}
+
+void orng::add_inflight(eosio::name dapp, uint64_t count) {
+    dappconfig_table_type dappconfig_table(get_self(), dapp.value);
+    auto inflight_it = dappconfig_table.find(dapp_inflight_index);
+    const uint64_t inflight = (inflight_it == dappconfig_table.end() ? 0 : inflight_it->value) + count;
+
+    auto max_it = dappconfig_table.find(dapp_max_inflight_index);
+    check(max_it == dappconfig_table.end() || inflight <= static_cast<uint64_t>(max_it->value),
+          "too many jobs in flight for " + dapp.to_string());
+
+    if (inflight_it == dappconfig_table.end()) {
+        dappconfig_table.emplace(dapp, [&](auto& rec) {
+            rec.name = dapp_inflight_index;
+            rec.value = inflight;
+        });
+    } else {
+        dappconfig_table.modify(inflight_it, same_payer, [&](auto& rec) {
+            rec.value = inflight;
+        });
+    }
+}
+
+void orng::release_inflight(eosio::name dapp) {
+    // jobs requested before the counter existed have nothing to release
+    dappconfig_table_type dappconfig_table(get_self(), dapp.value);
+    auto it = dappconfig_table.find(dapp_inflight_index);
+    if (it != dappconfig_table.end() && it->value > 0) {
+        dappconfig_table.modify(it, same_payer, [&](auto& rec) {
+            rec.value -= 1;
+        });
+    }
+}
+
+uint64_t orng::generate_next_index(uint64_t count) {
+    auto& state = get_hotstate();
+    uint64_t index_val = state.next_job_id;
+    state.next_job_id += count;
     return index_val;
 }
 
 uint64_t orng::update_current_public_key(uint64_t job_id) {
+    auto& state = get_hotstate();
+    if (state.active_last == 0 && state.active_key_index == 0) {
+        auto pubconfig = sigpubconfig_table.get();
+        auto it = sigpubkey_table.require_find(0, "sanity check");
+        if (it->last == 0) {
+            sigpubkey_table.modify(it, get_self(), [&](auto& rec) {
+                rec.last = job_id + (pubconfig.chance_to_switch - 1) * state.key_slots;
+            });
+        }
+        state.active_pubkey_hash_id = it->pubkey_hash_id;
+        state.active_last = it->last;
+        state.active_bucketed = is_bucketed_key(0);
+    }
+
+    // pubconfig.a and sigpubkey.c are only touched when the key of the slot runs out
+    const uint64_t slot = job_id % state.key_slots;
+    const auto key = key_slot_of(slot);
+    if (key.last >= job_id) {
+        return slot;
+    }
+
+    // the key signs chance_to_switch jobs of its slot, one job id in key_slots
     auto pubconfig = sigpubconfig_table.get();
-    auto it = sigpubkey_table.require_find(pubconfig.active_key_index, "sanity check");
-    if (it->last == 0 && pubconfig.active_key_index == 0) {
-        sigpubkey_table.modify(it, get_self(), [&](auto& rec) {
-            rec.last = job_id + pubconfig.chance_to_switch - 1;
+    const uint64_t last = job_id + (pubconfig.chance_to_switch - 1) * state.key_slots;
+
+    // with no key staged the key goes on rather than failing the request
+    if (pubconfig.active_key_index + 1 >= pubconfig.available_key_counter) {
+        auto key_it = sigpubkey_table.require_find(key.key_id, "sanity check");
+        sigpubkey_table.modify(key_it, get_self(), [&](auto& rec) {
+            rec.last = last;
         });
+        key.last = last;
+        state.keys_low = true;
+        return slot;
     }
 
-    if (it->last < job_id) {
-        pubconfig.active_key_index += 1;
-        sigpubconfig_table.set(pubconfig, get_self());
-        check(pubconfig.active_key_index < pubconfig.available_key_counter, "admin: no available public-key");
-        auto next_key_it = sigpubkey_table.require_find(pubconfig.active_key_index, "sanity check");
-        sigpubkey_table.modify(next_key_it, get_self(), [&](auto& rec) {
-            rec.last = job_id + pubconfig.chance_to_switch - 1;
+    keystats_table.emplace(get_self(), [&](auto& rec) {
+        rec.key_id = key.key_id;
+        rec.signing_values = key.signing_values;
+    });
+    key.signing_values = 0;
+
+    pubconfig.active_key_index += 1;
+    sigpubconfig_table.set(pubconfig, get_self());
+    update_keys_low(pubconfig);
+    auto next_key_it = sigpubkey_table.require_find(pubconfig.active_key_index, "sanity check");
+    sigpubkey_table.modify(next_key_it, get_self(), [&](auto& rec) {
+        rec.last = last;
+    });
+
+    key.key_id = next_key_it->id;
+    key.pubkey_hash_id = next_key_it->pubkey_hash_id;
+    key.last = last;
+    key.bucketed = is_bucketed_key(next_key_it->id);
+    return slot;
+}
+
+orng::key_slot_ref orng::key_slot_of(uint64_t slot) {
+    auto& state = get_hotstate();
+    if (slot == 0) {
+        return {state.active_key_index, state.active_pubkey_hash_id, state.active_last, state.active_bucketed,
+                get_stats().active_signing_values};
+    }
+    auto& key = state.extra_key_slots[slot - 1];
+    return {key.key_id, key.pubkey_hash_id, key.last, key.bucketed, key.signing_values};
+}
+
+bool orng::is_active_key(uint64_t key_id) {
+    const auto& state = get_hotstate();
+    return key_id == state.active_key_index ||
+           std::any_of(state.extra_key_slots.begin(), state.extra_key_slots.end(),
+                       [&](const auto& slot) { return slot.key_id == key_id; });
+}
+
+// keys are taken in id order, so every key below it is retired
+uint64_t orng::lowest_active_key() {
+    const auto& state = get_hotstate();
+    uint64_t lowest = state.active_key_index;
+    for (const auto& slot : state.extra_key_slots) {
+        lowest = std::min(lowest, slot.key_id);
+    }
+    return lowest;
+}
+
+void orng::update_keys_low(const sigpubkey_config& pubconfig) {
+    const uint64_t staged_keys = pubconfig.available_key_counter - pubconfig.active_key_index - 1;
+    get_hotstate().keys_low = staged_keys < static_cast<uint64_t>(get_config(key_low_watermark_index, default_key_low_watermark));
+}
+
+void orng::fulfill_results(const std::vector<std::pair<uint64_t, string>>& results, std::optional<uint64_t> shard) {
+    // the jobs of the key slots alternate between their keys
+    std::map<uint64_t, rsa_public_key> keys;
+
+    for (const auto& result : results) {
+        const uint64_t job_id = result.first;
+        check(!shard || job_shard(job_id) == *shard, "job belongs to another shard");
+
+        auto& lane = job_lane(job_id);
+        auto job_it = lane.find(job_id);
+        check(job_it != lane.end(), "Could not find job id.");
+
+        auto key_it = keys.find(job_it->key_id);
+        if (key_it == keys.end()) {
+            key_it = keys.emplace(job_it->key_id, to_rsa_public_key(sigpubkey_table.get(job_it->key_id, "sanity check"))).first;
+        }
+
+        fulfill_job(lane, job_it, key_it->second, result.second);
+    }
+
+    if (collect_signing_values()) {
+        save_hotstate();
+    }
+    save_stats();
+}
+
+void orng::fulfill_job(jobs_table_type& lane, jobs_table_type::const_iterator job_it, const rsa_public_key& key, const string& random_value) {
+    // derived signing values are not recorded, the job id keeps their message unique
+    const uint64_t message[] = {job_it->signing_value, job_it->id};
+    const size_t message_size = job_it->derived ? sizeof(message) : sizeof(message[0]);
+
+    check(verify_rsa_sha256_sig(
+            message, message_size, random_value, key.exponent, key.modulus),
+            "Could not verify signature.");
+
+    const uint64_t pull_ring_size = get_dapp_config(job_it->caller, dapp_pull_size_index, 0);
+    if (job_it->count == 1) {
+        checksum256 rv_hash = sha256(random_value.data(), random_value.size());
+
+        if (pull_ring_size > 0) {
+            store_pull_results(job_it->caller, pull_ring_size, job_it->assoc_id, {rv_hash});
+        } else {
+            action(
+                {get_self(), "active"_n},
+                job_it->caller, "receiverand"_n,
+                std::tuple(job_it->assoc_id, rv_hash))
+                .send();
+        }
+    } else {
+        // value i is sha256(random_value || i), i as a little-endian uint32
+        string buffer = random_value + string(sizeof(uint32_t), '\0');
+        char* index_bytes = buffer.data() + random_value.size();
+
+        std::vector<checksum256> rv_hashes;
+        rv_hashes.reserve(job_it->count);
+        for (uint32_t i = 0; i < job_it->count; ++i) {
+            for (size_t b = 0; b < sizeof(uint32_t); ++b) {
+                index_bytes[b] = static_cast<char>((i >> (8 * b)) & 0xFF);
+            }
+            rv_hashes.push_back(sha256(buffer.data(), buffer.size()));
+        }
+
+        if (pull_ring_size > 0) {
+            store_pull_results(job_it->caller, pull_ring_size, job_it->assoc_id, rv_hashes);
+        } else {
+            action(
+                {get_self(), "active"_n},
+                job_it->caller, "receiverands"_n,
+                std::tuple(job_it->assoc_id, rv_hashes))
+                .send();
+        }
+    }
+
+    auto& stats = get_stats();
+    stats.fulfilled += 1;
+    stats.depth = stats.depth > 0 ? stats.depth - 1 : 0;
+    stats.latency_histogram.resize(latency_buckets);
+    const uint32_t now = current_time_point().sec_since_epoch();
+    const uint32_t created = job_it->created.sec_since_epoch();
+    stats.latency_histogram[latency_bucket(now > created ? now - created : 0)] += 1;
+
+    release_inflight(job_it->caller);
+    lane.erase(job_it);
+}
+
+void orng::store_pull_results(name dapp, uint64_t ring_size, uint64_t assoc_id, const std::vector<checksum256>& random_values) {
+    uint64_t head = get_dapp_config(dapp, dapp_pull_head_index, 0);
+    const uint64_t tail = get_dapp_config(dapp, dapp_pull_tail_index, 0);
+
+    pullres_table_type pullres_table(get_self(), dapp.value);
+    for (uint32_t i = 0; i < random_values.size(); ++i) {
+        auto slot_it = pullres_table.require_find(head % ring_size, "sanity check: missing result slot");
+        pullres_table.modify(slot_it, same_payer, [&](auto& rec) {
+            rec.seq = head;
+            rec.assoc_id = assoc_id;
+            rec.index = i;
+            rec.random_value = random_values[i];
+        });
+        ++head;
+    }
+
+    // a full ring drops its oldest results rather than failing the fulfillment
+    set_dapp_config(dapp, dapp_pull_head_index, head, get_self());
+    if (head - tail > ring_size) {
+        set_dapp_config(dapp, dapp_pull_tail_index, head - ring_size, get_self());
+    }
+    require_recipient(dapp);
+}
+
+bool orng::is_bucketed_key(uint64_t key_id) const {
+    int64_t from_key_id = get_config(bucketed_key_index, -1);
+    return from_key_id >= 0 && key_id >= static_cast<uint64_t>(from_key_id);
+}
+
+void orng::use_signing_value(uint64_t signing_value, const name& payer, const key_slot_ref& key) {
+    key.signing_values += 1;
+    if (!key.bucketed) {
+        signvals_table_type signvals_table_by_scope(get_self(), key.pubkey_hash_id);
+        auto it = signvals_table_by_scope.find(signing_value);
+        check(it == signvals_table_by_scope.end(), "Signing value already used");
+
+        signvals_table_by_scope.emplace(payer, [&](auto& rec) {
+            rec.signing_value = signing_value;
         });
-        return next_key_it->pubkey_hash_id;
+        return;
+    }
+
+    // the dapp adding a value pays for the whole bucket, the previous payer is refunded,
+    // so requests never grow the RAM of the contract or of another dapp
+    signbucket_table_type signbucket_table(get_self(), key.pubkey_hash_id);
+    const uint64_t bucket = signing_value_bucket(signing_value);
+    auto it = signbucket_table.find(bucket);
+    if (it == signbucket_table.end()) {
+        signbucket_table.emplace(payer, [&](auto& rec) {
+            rec.bucket = bucket;
+            rec.signing_values.push_back(signing_value);
+        });
+        return;
+    }
+
+    auto pos = std::lower_bound(it->signing_values.begin(), it->signing_values.end(), signing_value);
+    check(pos == it->signing_values.end() || *pos != signing_value, "Signing value already used");
+    const auto offset = pos - it->signing_values.begin();
+    signbucket_table.modify(it, payer, [&](auto& rec) {
+        rec.signing_values.insert(rec.signing_values.begin() + offset, signing_value);
+    });
+}
+
+uint64_t orng::derive_signing_value(uint64_t job_id, uint64_t pubkey_hash_id) {
+    const uint64_t context[] = {job_id,
+                                pubkey_hash_id,
+                                uint64_t(uint32_t(tapos_block_num())),
+                                uint64_t(uint32_t(tapos_block_prefix()))};
+    return hash_to_int(sha256(reinterpret_cast<const char*>(context), sizeof(context)));
+}
+
+bool orng::is_signing_value_used(uint64_t signing_value) {
+    for (uint64_t slot = 0; slot < get_hotstate().key_slots; ++slot) {
+        const auto key = key_slot_of(slot);
+        if (!key.bucketed) {
+            signvals_table_type signvals_table_by_scope(get_self(), key.pubkey_hash_id);
+            if (signvals_table_by_scope.find(signing_value) != signvals_table_by_scope.end()) {
+                return true;
+            }
+            continue;
+        }
+
+        signbucket_table_type signbucket_table(get_self(), key.pubkey_hash_id);
+        auto it = signbucket_table.find(signing_value_bucket(signing_value));
+        if (it != signbucket_table.end() &&
+            std::binary_search(it->signing_values.begin(), it->signing_values.end(), signing_value)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t orng::erase_signing_values(uint64_t scope, bool bucketed, uint64_t rows_num, bool erase_v1, uint64_t& values_erased) {
+    // the signing value was placed in the table under self scope to support contracts that still require the legacy tracking
+    auto erase_v1_value = [&](uint64_t signing_value) {
+        auto v1_itr = signvals_table_v1_support.find(signing_value);
+        if (v1_itr != signvals_table_v1_support.end()) {
+            signvals_table_v1_support.erase(v1_itr);
+        }
+    };
+
+    uint64_t erased = 0;
+    if (bucketed) {
+        signbucket_table_type signbucket_table(get_self(), scope);
+        auto itr = signbucket_table.begin();
+        while (itr != signbucket_table.end() && erased < rows_num) {
+            if (erase_v1) {
+                for (auto signing_value : itr->signing_values) {
+                    erase_v1_value(signing_value);
+                }
+            }
+            values_erased += itr->signing_values.size();
+            itr = signbucket_table.erase(itr);
+            ++erased;
+        }
+        return erased;
+    }
+
+    signvals_table_type signvals_table_by_scope(get_self(), scope);
+    auto itr = signvals_table_by_scope.begin();
+    while (itr != signvals_table_by_scope.end() && erased < rows_num) {
+        const uint64_t signing_value = itr->signing_value;
+        itr = signvals_table_by_scope.erase(itr);
+        if (erase_v1) {
+            erase_v1_value(signing_value);
+        }
+        ++values_erased;
+        ++erased;
+    }
+    return erased;
+}
+
+bool orng::collect_signing_values() {
+    auto& state = get_hotstate();
+    const uint64_t gc_key_id = state.gc_key_id;
+
+    uint64_t rows_num = state.gc_rows_per_call;
+    const uint64_t lowest_active = lowest_active_key();
+    while (rows_num > 0 && state.gc_key_id < lowest_active) {
+        auto key_it = sigpubkey_table.require_find(state.gc_key_id, "sanity check");
+        uint64_t values_erased = 0;
+        uint64_t erased = erase_signing_values(key_it->pubkey_hash_id, is_bucketed_key(key_it->id), rows_num, false, values_erased);
+        forget_signing_values(key_it->id, values_erased);
+
+        // less rows than asked for means the key has no signing values left
+        if (erased < rows_num) {
+            state.gc_key_id += 1;
+        }
+        rows_num -= erased;
+    }
+
+    return state.gc_key_id != gc_key_id;
+}
+
+uint64_t orng::first_slot_job(uint64_t job_id, uint64_t slot, uint64_t slots) {
+    // the first job from job_id in the slot, job ids go round the slots
+    return job_id + (slot + slots - job_id % slots) % slots;
+}
+
+uint64_t orng::signing_value_bucket(uint64_t signing_value) {
+    // dapps often use small or sequential signing values, so they are mixed
+    // (splitmix64 finalizer) before taking the high bits
+    uint64_t z = signing_value;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z = z ^ (z >> 31);
+    return z >> (64 - signing_value_bucket_bits);
+}
+
+orng::rsa_public_key orng::to_rsa_public_key(const sigpubkey_c& key) {
+    return rsa_public_key{bytes_to_hex(key.exponent), bytes_to_hex(key.modulus)};
+}
+
+std::vector<char> orng::hex_to_bytes(const string& hex) {
+    auto nibble = [](char c) -> uint8_t {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        check(false, "public key must be a hex string");
+        return 0;
+    };
+
+    // an odd number of digits gets an implicit leading zero
+    std::vector<char> bytes((hex.size() + 1) / 2);
+    size_t digit = hex.size() % 2 == 0 ? 0 : 1;
+    for (size_t i = 0; i < hex.size(); ++i, ++digit) {
+        bytes[digit / 2] |= nibble(hex[i]) << (digit % 2 == 0 ? 4 : 0);
+    }
+    return bytes;
+}
+
+string orng::bytes_to_hex(const std::vector<char>& bytes) {
+    static constexpr char hex_digits[] = "0123456789abcdef";
+
+    string hex(bytes.size() * 2, '0');
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        hex[2 * i] = hex_digits[(bytes[i] >> 4) & 0xF];
+        hex[2 * i + 1] = hex_digits[bytes[i] & 0xF];
     }
 
-    return it->pubkey_hash_id;
+    // keep the leading zeroes stripped like the hex strings given to setsigpubkey
+    auto first_digit = hex.find_first_not_of('0');
+    hex.erase(0, first_digit == string::npos ? hex.size() - 1 : first_digit);
+    return hex;
 }
 
 uint64_t orng::hash_to_int(const eosio::checksum256& value) {
@@ -408,14 +1548,42 @@ EOSIO_DISPATCH(orng,
     (pauserequest)
     (dapperror)
     (seterrorsize)
+    (setpullmode)
+    (claimrand)
+    (seterrmsgmax)
     (version)
     (requestrand)
+    (requestrands)
+    (subscribe)
+    (unsubscribe)
+    (setstreamcap)
+    (setstreamrnd)
     (v1rrcompat)
+    (setv1compat)
+    (purgev1vals)
     (setbwpayer)
     (acceptbwpay)
     (setrand)
+    (setrandbatch)
     (killjobs)
+    (expirejobs)
+    (jobexpired)
+    (setinflight)
+    (getdepths)
+    (setlaneweight)
+    (getnextjobs)
+    (setshards)
+    (setrandshard)
+    (getshardjobs)
+    (getjobfeed)
+    (getstats)
     (setsigpubkey)
+    (setpubkeys)
+    (setlowmark)
+    (setkeyslots)
+    (migratekeys)
     (cleansigvals)
     (setchance)
+    (setbucketed)
+    (setgcrows)
 )
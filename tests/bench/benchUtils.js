@@ -0,0 +1,142 @@
+const {
+  setupTestChain,
+  createAccount,
+  setContract,
+  updateAuth,
+  getTableRows,
+  TESTING_PUBLIC_KEY,
+  genericAction,
+} = require('@waxio/waxunit');
+
+const fs = require('fs');
+const path = require('path');
+const NodeRSA = require('node-rsa');
+const { RSASigning } = require('../rsaSigning.js');
+
+const orngContract = "orng.test";
+const orngOracle = "oracle.wax";
+const orngV1Oracle = "oraclev1.wax";
+const dappContract = "dapp.wax";
+
+function codePermission() {
+  return {
+    threshold: 1,
+    accounts: [
+      {
+        permission: {
+          actor: orngContract,
+          permission: `eosio.code`,
+        },
+        weight: 1,
+      },
+    ],
+    keys: [
+      {
+        key: TESTING_PUBLIC_KEY,
+        weight: 1,
+      },
+    ],
+    waits: [],
+  };
+}
+
+// exponent and modulus of a bundled test key, in the hex form expected by setsigpubkey
+function loadSigningKey(index) {
+  const privateKey = fs.readFileSync(`./tests/resources/test_rsa_4096_priv_${index}.pem`, 'utf8');
+  const { n, e } = new NodeRSA(privateKey).exportKey('components-public');
+  return {
+    privateKey,
+    signer: new RSASigning(privateKey),
+    exponent: e.toString(16),
+    modulus: n.toString('hex').replace(/^0+/, ''),
+  };
+}
+
+async function deployOrng() {
+  await setupTestChain();
+
+  await createAccount(orngContract, 800000);
+  await createAccount(orngOracle, 500000);
+  await createAccount(orngV1Oracle, 500000);
+  await createAccount(dappContract, 500000);
+
+  await setContract(
+    orngContract,
+    'build/wax.orng.wasm',
+    'build/wax.orng.abi'
+  );
+
+  await setContract(
+    dappContract,
+    'build/wax.orng.tests.randreceiver.wasm',
+    'build/wax.orng.tests.randreceiver.abi'
+  );
+
+  await updateAuth(orngContract, `active`, `owner`, codePermission());
+  await updateAuth(orngV1Oracle, `active`, `owner`, codePermission());
+
+  const key = loadSigningKey(0);
+  await oracleAction("setsigpubkey", { id: 0, exponent: key.exponent, modulus: key.modulus });
+  return key;
+}
+
+function oracleAction(action, data) {
+  return genericAction(orngContract, action, data, [{ actor: orngOracle, permission: "active" }]);
+}
+
+function dappAction(action, data) {
+  return genericAction(orngContract, action, data, [{ actor: dappContract, permission: "active" }]);
+}
+
+// requests `count` jobs and returns their rows in job id order
+async function requestJobs(count, firstSigningValue) {
+  for (let i = 0; i < count; i++) {
+    await dappAction("requestrand", {
+      assoc_id: i,
+      signing_value: firstSigningValue + i,
+      caller: dappContract,
+    });
+  }
+  const jobs_tbl = await getTableRows(orngContract, "jobs.a", orngContract);
+  return jobs_tbl.slice(-count);
+}
+
+function cpuUsage(rsp) {
+  return rsp.processed.receipt.cpu_usage_us;
+}
+
+function netUsage(rsp) {
+  return rsp.processed.receipt.net_usage_words * 8;
+}
+
+// RAM bytes billed by the transaction, summed over every account and action
+function ramUsage(rsp) {
+  return rsp.processed.action_traces.reduce(
+    (total, trace) => total + (trace.account_ram_deltas || []).reduce((sum, d) => sum + d.delta, 0),
+    0
+  );
+}
+
+// writes a machine-readable report to $ORNG_BENCH_REPORT_DIR (build/bench by default)
+function writeReport(name, report) {
+  const dir = process.env.ORNG_BENCH_REPORT_DIR || 'build/bench';
+  fs.mkdirSync(dir, { recursive: true });
+  const file = path.join(dir, `${name}.json`);
+  fs.writeFileSync(file, JSON.stringify(report, null, 2) + '\n');
+  return file;
+}
+
+module.exports = {
+  orngContract,
+  orngOracle,
+  dappContract,
+  loadSigningKey,
+  deployOrng,
+  oracleAction,
+  dappAction,
+  requestJobs,
+  cpuUsage,
+  netUsage,
+  ramUsage,
+  writeReport,
+};
@@ -0,0 +1,130 @@
+const { getTableRows } = require('@waxio/waxunit');
+const {
+  orngContract,
+  dappContract,
+  deployOrng,
+  oracleAction,
+  dappAction,
+  loadSigningKey,
+  cpuUsage,
+  netUsage,
+  ramUsage,
+  writeReport,
+} = require('./benchUtils.js');
+
+// signing values of each key, one key per step so signvals.a and jobs.a grow
+// step after step; at most 3 steps, the 4th bundled key takes the last rotation
+const STEP_SIZES = (process.env.ORNG_BENCH_SIZES || "1000,5000,20000").split(",").map(Number);
+const LOOP_ITERATIONS = Number(process.env.ORNG_BENCH_LOOPS || 100);
+const REQUESTS_PER_ACTION = 50;
+const CLEAN_ROWS = 500;
+
+function summarize(samples) {
+  const sorted = [...samples].sort((a, b) => a - b);
+  const at = q => sorted[Math.min(sorted.length - 1, Math.floor(q * sorted.length))];
+  return {
+    mean: sorted.reduce((sum, v) => sum + v, 0) / sorted.length,
+    p50: at(0.5),
+    p95: at(0.95),
+    max: sorted[sorted.length - 1],
+  };
+}
+
+describe('requestrand, setrand and cleansigvals cost as the tables grow', () => {
+  const keys = [];
+  const report = [];
+  let signingValue = 1;
+  let pendingJobs = 0;
+
+  function record(action, step, responses) {
+    report.push({
+      action,
+      key_signing_values: STEP_SIZES[step],
+      pending_jobs: pendingJobs,
+      calls: responses.length,
+      cpu_us: summarize(responses.map(cpuUsage)),
+      net_bytes: summarize(responses.map(netUsage)),
+      ram_bytes: summarize(responses.map(ramUsage)),
+    });
+  }
+
+  // jobs left pending, so jobs.a grows with the steps
+  async function fillBacklog(count) {
+    for (let i = 0; i < count; i += REQUESTS_PER_ACTION) {
+      const requests = [];
+      for (let j = i; j < Math.min(count, i + REQUESTS_PER_ACTION); j++) {
+        requests.push({ first: j, second: signingValue++ });
+      }
+      await dappAction("requestrands", { requests, caller: dappContract });
+    }
+    pendingJobs += count;
+  }
+
+  beforeAll(async () => {
+    jest.setTimeout(3600000);
+    if (STEP_SIZES.length > 3 || STEP_SIZES.some(size => size <= LOOP_ITERATIONS)) {
+      throw new Error("ORNG_BENCH_SIZES takes up to 3 sizes, each above ORNG_BENCH_LOOPS");
+    }
+    keys.push(await deployOrng());
+    for (let id = 1; id <= STEP_SIZES.length; id++) {
+      const key = loadSigningKey(id);
+      await oracleAction("setsigpubkey", { id, exponent: key.exponent, modulus: key.modulus });
+      keys.push(key);
+    }
+    await oracleAction("setchance", { chance_to_switch: STEP_SIZES[0] });
+  });
+
+  afterAll(() => {
+    const file = writeReport("load", { step_sizes: STEP_SIZES, loop_iterations: LOOP_ITERATIONS, actions: report });
+    console.table(report.map(row => ({
+      action: row.action,
+      key_signing_values: row.key_signing_values,
+      pending_jobs: row.pending_jobs,
+      cpu_us_mean: row.cpu_us.mean,
+      cpu_us_p95: row.cpu_us.p95,
+      net_bytes_mean: row.net_bytes.mean,
+      ram_bytes_mean: row.ram_bytes.mean,
+    })));
+    console.log(`report written to ${file}`);
+  });
+
+  STEP_SIZES.forEach((size, step) => {
+    it(`should measure a sustained loop with ${size} signing values per key`, async () => {
+      // the request of the previous step that rotated the keys counts for this one
+      await fillBacklog(size - LOOP_ITERATIONS - (step > 0 ? 1 : 0));
+      if (step + 1 < STEP_SIZES.length) {
+        await oracleAction("setchance", { chance_to_switch: STEP_SIZES[step + 1] });
+      }
+
+      const requests = [];
+      const fulfillments = [];
+      for (let i = 0; i < LOOP_ITERATIONS; i++) {
+        const signing_value = signingValue++;
+        requests.push(await dappAction("requestrand", { assoc_id: i, signing_value, caller: dappContract }));
+
+        // the backlog is too large to be read back, the job id comes from the counter
+        const hotstate_tbl = await getTableRows(orngContract, "hotstate.a", orngContract);
+        fulfillments.push(await oracleAction("setrand", {
+          job_id: hotstate_tbl[0].next_job_id - 1,
+          random_value: keys[step].signer.generateRandomNumber(signing_value),
+        }));
+      }
+      record("requestrand", step, requests);
+      record("setrand", step, fulfillments);
+    });
+
+    it(`should measure cleansigvals of a retired key with ${size} signing values`, async () => {
+      // one more request retires the key of this step
+      await dappAction("requestrand", { assoc_id: 0, signing_value: signingValue++, caller: dappContract });
+      pendingJobs += 1;
+
+      const sigpubkey_tbl = await getTableRows(orngContract, "sigpubkey.c", orngContract);
+      const scope = sigpubkey_tbl.find(key => key.id === step).pubkey_hash_id;
+      const cleanups = [];
+      for (let rows = 0; rows < size; rows += CLEAN_ROWS) {
+        cleanups.push(await oracleAction("cleansigvals", { scope, rows_num: CLEAN_ROWS }));
+      }
+      record("cleansigvals", step, cleanups);
+    });
+  });
+});
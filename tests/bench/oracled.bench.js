@@ -0,0 +1,65 @@
+const { spawn } = require('child_process');
+const {
+  orngContract,
+  orngOracle,
+  dappContract,
+  deployOrng,
+  oracleAction,
+  dappAction,
+  writeReport,
+} = require('./benchUtils.js');
+
+// orng_oracled of tools/oracle, fulfilling the jobs through the node HTTP API
+const ORACLED = process.env.ORNG_ORACLED || 'build-oracle/orng_oracled';
+const NODE_URL = process.env.ORNG_NODE_URL || 'http://127.0.0.1:8888';
+// the development key of the test chain accounts
+const ORACLE_KEY = process.env.ORNG_ORACLE_KEY || '5KQwrPbwdL6PhXujxW37FSSQZ1JiwsST4cqQzDeyXtP79zkvFD3';
+const JOBS = Number(process.env.ORNG_BENCH_JOBS || 2000);
+const REQUESTS_PER_ACTION = 50;
+
+function runOracle(args) {
+  return new Promise((resolve, reject) => {
+    const oracle = spawn(ORACLED, args, { env: { ...process.env, ORNG_ORACLE_TX_KEY: ORACLE_KEY } });
+    let log = '';
+    oracle.stderr.on('data', chunk => { log += chunk; });
+    oracle.on('error', reject);
+    oracle.on('close', code => resolve({ code, log }));
+  });
+}
+
+describe('orng_oracled end to end', () => {
+  beforeAll(async () => {
+    jest.setTimeout(3600000);
+    await deployOrng();
+    // the jobs are spread over two shards, which the oracle reads through getjobfeed
+    await oracleAction("setshards", { shards: 2 });
+  });
+
+  it(`should fulfill ${JOBS} jobs`, async () => {
+    for (let i = 0; i < JOBS; i += REQUESTS_PER_ACTION) {
+      const requests = [];
+      for (let j = i; j < Math.min(JOBS, i + REQUESTS_PER_ACTION); j++) {
+        requests.push({ first: j, second: j + 1 });
+      }
+      await dappAction("requestrands", { requests, caller: dappContract });
+    }
+
+    const start = Date.now();
+    const { code, log } = await runOracle([
+      '--url', NODE_URL,
+      '--contract', orngContract,
+      '--account', orngOracle,
+      '--rsa-key', '0=tests/resources/test_rsa_4096_priv_0.pem',
+      '--poll-ms', '200',
+      '--exit-after', String(JOBS),
+    ]);
+    const seconds = (Date.now() - start) / 1000;
+    console.log(log);
+
+    expect(code).toEqual(0);
+    const feed = await oracleAction("getjobfeed", { cursor: 0, max_jobs: 1 });
+    expect(feed.processed.action_traces[0].return_value_data.jobs).toHaveLength(0);
+    const file = writeReport("oracled", { jobs: JOBS, seconds, jobs_per_second: JOBS / seconds });
+    console.log(`report written to ${file}`);
+  });
+});
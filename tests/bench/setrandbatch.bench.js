@@ -0,0 +1,57 @@
+const {
+  deployOrng,
+  oracleAction,
+  requestJobs,
+  cpuUsage,
+} = require('./benchUtils.js');
+
+const JOBS_PER_RUN = 50;
+const BATCH_SIZES = [1, 5, 10, 25, 50];
+
+describe('setrand vs setrandbatch CPU per job', () => {
+  let key;
+  let signingValue = 1;
+  const report = [];
+
+  beforeAll(async () => {
+    jest.setTimeout(600000);
+    key = await deployOrng();
+  });
+
+  afterAll(() => {
+    console.table(report);
+  });
+
+  it("should measure single fulfillment", async () => {
+    const jobs = await requestJobs(JOBS_PER_RUN, signingValue);
+    signingValue += JOBS_PER_RUN;
+
+    let cpu = 0;
+    for (const job of jobs) {
+      const rsp = await oracleAction("setrand", {
+        job_id: job.id,
+        random_value: key.signer.generateRandomNumber(job.signing_value),
+      });
+      cpu += cpuUsage(rsp);
+    }
+    report.push({ action: "setrand", batch: 1, jobs: jobs.length, cpu_us_per_job: cpu / jobs.length });
+  });
+
+  for (const batchSize of BATCH_SIZES) {
+    it(`should measure batched fulfillment of ${batchSize} jobs`, async () => {
+      const jobs = await requestJobs(JOBS_PER_RUN, signingValue);
+      signingValue += JOBS_PER_RUN;
+
+      let cpu = 0;
+      for (let i = 0; i < jobs.length; i += batchSize) {
+        const results = jobs.slice(i, i + batchSize).map(job => ({
+          first: job.id,
+          second: key.signer.generateRandomNumber(job.signing_value),
+        }));
+        const rsp = await oracleAction("setrandbatch", { results });
+        cpu += cpuUsage(rsp);
+      }
+      report.push({ action: "setrandbatch", batch: batchSize, jobs: jobs.length, cpu_us_per_job: cpu / jobs.length });
+    });
+  }
+});
@@ -23,29 +23,45 @@
 #include <eosio/eosio.hpp>
 #include <eosio/print.hpp>
 
+#include "orng_client.hpp"
+
 #include <stdint.h>
-#include <string>
+#include <vector>
 
 using namespace eosio;
 
-CONTRACT randreceiver: public contract {
+// Reference receiver, the tests deploy the orng contract to orng.test
+CONTRACT randreceiver: public orng_client::receiver<randreceiver, "orng.test"_n> {
 public:
     randreceiver(name receiver, name code, datastream<const char*> ds)
-        : contract(receiver, code, ds)
+        : orng_client::receiver<randreceiver, "orng.test"_n>(receiver, code, ds)
         , results_table(receiver, receiver.value) {
     }
 
     ACTION receiverand(uint64_t assoc_id, const eosio::checksum256& random_value) {
-        auto rv_byte_array = random_value.extract_as_byte_array();
-        auto rv_string = bytes_to_string(rv_byte_array.data(), rv_byte_array.size());
-
-        print_f("receiverand called: assoc_id=%, random_value=%\n", assoc_id, rv_string );
+        deliver(assoc_id, random_value);
+    }
 
-        set_last_result(assoc_id, random_value);
+    ACTION receiverands(uint64_t assoc_id, const std::vector<eosio::checksum256>& random_values) {
+        deliver(assoc_id, random_values);
     }
 
     ACTION resetresult() {
-        set_last_result(0, eosio::checksum256());
+        set_last_result(0, eosio::checksum256(), {}, 0);
+    }
+
+    void on_random(uint64_t assoc_id, const eosio::checksum256& random_value) {
+        print_f("receiverand called: assoc_id=%, random_value=%\n", assoc_id, random_value);
+
+        orng_client::random_stream rng(random_value);
+        set_last_result(assoc_id, random_value, {}, rng.roll(6));
+    }
+
+    void on_random_values(uint64_t assoc_id, const std::vector<eosio::checksum256>& random_values) {
+        print_f("receiverands called: assoc_id=%, count=%\n", assoc_id, random_values.size());
+
+        orng_client::random_stream rng(random_values.front());
+        set_last_result(assoc_id, random_values.front(), random_values, rng.roll(6));
     }
 
 private:
@@ -53,41 +69,34 @@ private:
         uint64_t    id;
         uint64_t    assoc_id;
         eosio::checksum256 random_value;
+        std::vector<eosio::checksum256> random_values;
+        uint64_t    roll; // a six-sided die rolled from the first random value
 
         auto primary_key() const { return id; }
     };
     
     multi_index<"results"_n, results> results_table;
 
-    void set_last_result(uint64_t assoc_id, const eosio::checksum256& random_value) {
-        auto it = results_table.find(0);
+    void set_last_result(uint64_t assoc_id,
+                         const eosio::checksum256& random_value,
+                         const std::vector<eosio::checksum256>& random_values,
+                         uint64_t roll) {
+        auto update_result_fn = [&](auto& rec) {
+            rec.id = 0;
+            rec.assoc_id = assoc_id;
+            rec.random_value = random_value;
+            rec.random_values = random_values;
+            rec.roll = roll;
+        };
 
+        auto it = results_table.find(0);
         if (it == results_table.end()) {
-            results_table.emplace(get_self(), [&](auto& rec) {
-                rec.id = 0;
-                rec.assoc_id = assoc_id;
-                rec.random_value = random_value;
-            });
+            results_table.emplace(get_self(), update_result_fn);
         }
         else {
-            results_table.modify(it, get_self(), [&](auto& rec) {
-                rec.assoc_id = assoc_id;
-                rec.random_value = random_value;
-            });
-        }
-    }
-
-
-    static std::string bytes_to_string(const unsigned char* in, std::size_t size) {
-        std::string out;
-        const char* hex = "0123456789abcdef";
-        for (std::size_t i = 0; i < size; i++) {
-            out += hex[(in[i]>>4) & 0xF];
-            out += hex[in[i] & 0xF];
+            results_table.modify(it, get_self(), update_result_fn);
         }
-        return out;
     }
-   
 };
 
-EOSIO_DISPATCH(randreceiver, (receiverand)(resetresult))
+EOSIO_DISPATCH(randreceiver, (receiverand)(receiverands)(resetresult))
@@ -0,0 +1,266 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Host benchmarks of the hot actions at growing table sizes. Every action runs
+// on a fresh contract object, as on chain, against the in-memory tables of
+// include/eosio. RSA verification is stubbed out so the contract code itself
+// is measured, and inline actions are only counted.
+//
+//   orng_bench [--max_rows=N] [benchmark flags]
+//
+// --max_rows caps the table sizes (1K to 10M rows by default), the largest
+// ones need a few GB of memory.
+
+#include "orng.hpp"
+
+#include <eosio/crypto.hpp>
+#include <eosio/mock.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace eosio;
+
+namespace {
+
+const name self = "orng.wax"_n;
+const name dapp = "dapp.bench"_n;
+const std::string exponent = "10001";
+const std::string modulus0 = "c0ffee01";
+const std::string modulus1 = "c0ffee02";
+const binary_extension<uint32_t> single_value;
+
+constexpr uint64_t request_chunk = 1000;
+constexpr uint64_t cleansigvals_rows = 100;
+
+// RAM billed by the chain for each row on top of its serialized size, and for
+// each table scope (billable_size of key_value_object and table_id_object)
+constexpr uint64_t row_overhead_bytes = 108;
+constexpr uint64_t scope_overhead_bytes = 108;
+
+orng contract() {
+    static const char data[1] = {};
+    return orng(self, self, datastream<const char*>(data, 0));
+}
+
+// pubkey_hash_id of a key, the scope of its signing values (see orng::hash_to_int)
+uint64_t pubkey_hash_id(const std::string& modulus) {
+    auto bytes = sha256(modulus.c_str(), modulus.size()).extract_as_byte_array();
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value <<= 8;
+        value |= bytes[i] & 127;
+    }
+    return value;
+}
+
+// a fresh chain with key 0 signing the first jobs_per_key jobs and key 1 staged
+void setup_keys(uint64_t jobs_per_key) {
+    mock::reset();
+    contract().setsigpubkey(0, exponent, modulus0);
+    contract().setchance(jobs_per_key);
+    contract().setsigpubkey(1, exponent, modulus1);
+}
+
+// requests the jobs with ids [first, first + count), signing value is the job id + 1
+// as 0 asks for a derived one
+void request_jobs(uint64_t first, uint64_t count) {
+    std::vector<std::pair<uint64_t, uint64_t>> requests;
+    for (uint64_t id = first; id < first + count; id += requests.size()) {
+        requests.clear();
+        for (uint64_t i = id; i < first + count && requests.size() < request_chunk; ++i) {
+            requests.emplace_back(i, i + 1);
+        }
+        contract().requestrands(requests, dapp);
+    }
+}
+
+void kill_jobs(uint64_t first, uint64_t count) {
+    std::vector<uint64_t> job_ids;
+    for (uint64_t id = first; id < first + count; id += job_ids.size()) {
+        job_ids.clear();
+        for (uint64_t i = id; i < first + count && job_ids.size() < request_chunk; ++i) {
+            job_ids.push_back(i);
+        }
+        contract().killjobs(job_ids);
+    }
+}
+
+// requestrand with N pending jobs and N signing values of the active key
+void BM_requestrand(benchmark::State& state) {
+    const uint64_t rows = state.range(0);
+    setup_keys(UINT64_MAX / 2);
+    request_jobs(0, rows);
+
+    uint64_t job_id = rows;
+    for (auto _ : state) {
+        contract().requestrand(job_id, job_id + 1, dapp, single_value);
+        ++job_id;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// requestrand with N pending jobs, the signing value derived by the contract
+void BM_requestrand_derived(benchmark::State& state) {
+    const uint64_t rows = state.range(0);
+    setup_keys(UINT64_MAX / 2);
+    request_jobs(0, rows);
+
+    uint64_t job_id = rows;
+    for (auto _ : state) {
+        contract().requestrand(job_id, 0, dapp, single_value);
+        ++job_id;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// setrand with N pending jobs, each fulfilled job is replaced by a new one
+void BM_setrand(benchmark::State& state) {
+    const uint64_t rows = state.range(0);
+    setup_keys(UINT64_MAX / 2);
+    request_jobs(0, rows);
+
+    uint64_t job_id = 0;
+    for (auto _ : state) {
+        contract().setrand(job_id, "signature");
+        ++job_id;
+
+        state.PauseTiming();
+        request_jobs(rows + job_id - 1, 1);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// cleansigvals sweeping the N signing values of a retired key, 100 rows per call
+void BM_cleansigvals(benchmark::State& state) {
+    const uint64_t rows = state.range(0);
+    setup_keys(rows);
+    request_jobs(0, rows);
+    kill_jobs(0, rows);
+    request_jobs(rows, 1); // rotates to key 1
+
+    const uint64_t scope = pubkey_hash_id(modulus0);
+    for (auto _ : state) {
+        contract().cleansigvals(scope, cleansigvals_rows);
+    }
+    state.SetItemsProcessed(state.iterations() * cleansigvals_rows);
+}
+
+// serialized size of a vector length
+uint64_t varuint32_size(uint64_t value) {
+    uint64_t size = 1;
+    for (; value >= 0x80; value >>= 7) {
+        ++size;
+    }
+    return size;
+}
+
+// requestrand filling the replay protection of a key with N signing values,
+// reporting the RAM of signvals.a, or of signbucket.a when range(1) is set,
+// per signing value. Only the replay tables are counted, not the jobs.
+void BM_replay_layout(benchmark::State& state) {
+    const uint64_t rows = state.range(0);
+    const bool bucketed = state.range(1) != 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        setup_keys(UINT64_MAX / 2);
+        if (bucketed) {
+            contract().setbucketed(0);
+        }
+        state.ResumeTiming();
+
+        request_jobs(0, rows);
+    }
+
+    const uint64_t scope = pubkey_hash_id(modulus0);
+    uint64_t table_rows = 0;
+    uint64_t bytes = scope_overhead_bytes;
+    if (!bucketed) {
+        table_rows = mock::table_rows(self, scope, "signvals.a"_n);
+        bytes += table_rows * (row_overhead_bytes + sizeof(uint64_t));
+    } else {
+        // bucket id, vector length at the mean bucket size, and the values
+        table_rows = mock::table_rows(self, scope, "signbucket.a"_n);
+        bytes += table_rows * (row_overhead_bytes + sizeof(uint64_t) + varuint32_size(rows / table_rows)) +
+                 rows * sizeof(uint64_t);
+    }
+    state.counters["table_rows"] = table_rows;
+    state.counters["ram_bytes_per_value"] = double(bytes) / rows;
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+
+// dapperror overwriting the oldest slot of a full log of N errors
+void BM_dapperror(benchmark::State& state) {
+    const uint64_t rows = state.range(0);
+    const std::string message(64, 'e');
+    setup_keys(UINT64_MAX / 2);
+    request_jobs(0, 1);
+    contract().seterrorsize(dapp, rows);
+    for (uint64_t i = 0; i < rows; ++i) {
+        contract().dapperror(0, message);
+    }
+
+    for (auto _ : state) {
+        contract().dapperror(0, message);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t max_rows = 10'000'000;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--max_rows=", 11) == 0) {
+            max_rows = std::strtoull(argv[i] + 11, nullptr, 10);
+            std::move(argv + i + 1, argv + argc, argv + i);
+            --argc;
+            break;
+        }
+    }
+
+    for (uint64_t rows = 1000; rows <= max_rows; rows *= 10) {
+        benchmark::RegisterBenchmark("requestrand", BM_requestrand)->Arg(rows);
+        benchmark::RegisterBenchmark("requestrand_derived", BM_requestrand_derived)->Arg(rows);
+        benchmark::RegisterBenchmark("setrand", BM_setrand)->Arg(rows);
+        // the sweep ends when the key has no signing values left
+        benchmark::RegisterBenchmark("cleansigvals", BM_cleansigvals)->Arg(rows)
+            ->Iterations(rows / cleansigvals_rows > 0 ? rows / cleansigvals_rows : 1);
+        benchmark::RegisterBenchmark("dapperror", BM_dapperror)->Arg(rows);
+        benchmark::RegisterBenchmark("replay_layout", BM_replay_layout)
+            ->ArgNames({"values", "bucketed"})->Args({int64_t(rows), 0})->Args({int64_t(rows), 1})->Iterations(1);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,101 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Host benchmarks of the reference receiver built on orng_client.hpp, i.e.
+// the CPU a dapp spends per callback, and of the random_stream helpers.
+
+#include "../../contracts/randreceiver.cpp"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+eosio::checksum256 random_value(uint64_t n) {
+    std::array<uint8_t, 32> bytes{};
+    for (size_t i = 0; i < sizeof(n); ++i) {
+        bytes[i] = static_cast<uint8_t>(n >> (8 * i));
+    }
+    return eosio::sha256(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+randreceiver receiver_contract() {
+    static const char data[1] = {};
+    return randreceiver("dapp.bench"_n, "dapp.bench"_n, eosio::datastream<const char*>(data, 0));
+}
+
+void BM_receiverand(benchmark::State& state) {
+    eosio::mock::reset();
+    const auto value = random_value(1);
+
+    uint64_t assoc_id = 0;
+    for (auto _ : state) {
+        receiver_contract().receiverand(assoc_id++, value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_receiverand);
+
+void BM_receiverands(benchmark::State& state) {
+    eosio::mock::reset();
+    std::vector<eosio::checksum256> values;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        values.push_back(random_value(i));
+    }
+
+    uint64_t assoc_id = 0;
+    for (auto _ : state) {
+        receiver_contract().receiverands(assoc_id++, values);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_receiverands)->Arg(16)->Arg(256);
+
+void BM_shuffle_deck(benchmark::State& state) {
+    const auto value = random_value(2);
+    std::array<uint8_t, 52> deck;
+    std::iota(deck.begin(), deck.end(), 0);
+
+    for (auto _ : state) {
+        orng_client::random_stream rng(value);
+        rng.shuffle(deck.begin(), deck.end());
+        benchmark::DoNotOptimize(deck);
+    }
+}
+BENCHMARK(BM_shuffle_deck);
+
+void BM_pick_weighted(benchmark::State& state) {
+    const auto value = random_value(3);
+    const std::array<uint64_t, 8> weights = {50, 25, 12, 6, 3, 2, 1, 1};
+
+    for (auto _ : state) {
+        orng_client::random_stream rng(value);
+        benchmark::DoNotOptimize(rng.pick_weighted(weights.begin(), weights.end()));
+    }
+}
+BENCHMARK(BM_pick_weighted);
+
+} // namespace
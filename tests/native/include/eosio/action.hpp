@@ -0,0 +1,60 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <eosio/mock.hpp>
+#include <eosio/name.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace eosio {
+
+// Inline actions are not executed: send() only counts (and optionally records) them
+struct action {
+    eosio::name account;
+    eosio::name name;
+    std::vector<permission_level> authorization;
+
+    template <typename T>
+    action(const permission_level& auth, eosio::name a, eosio::name n, T&&)
+        : account(a), name(n), authorization(1, auth) {}
+
+    template <typename T>
+    action(std::vector<permission_level> auths, eosio::name a, eosio::name n, T&&)
+        : account(a), name(n), authorization(std::move(auths)) {}
+
+    void send() const {
+        auto& c = mock::chain();
+        ++c.actions_sent;
+        if (c.record_actions)
+            c.sent_actions.push_back({account, name, authorization});
+    }
+};
+
+template <eosio::name::raw Name, auto Action>
+struct action_wrapper {
+    static constexpr eosio::name action_name = eosio::name(Name);
+};
+
+} // namespace eosio
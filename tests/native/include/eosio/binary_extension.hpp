@@ -0,0 +1,67 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <eosio/check.hpp>
+
+#include <optional>
+#include <utility>
+
+namespace eosio {
+
+// Optional trailing field: absent when the serialized data ends before it
+template <typename T>
+class binary_extension {
+public:
+    using value_type = T;
+
+    constexpr binary_extension() = default;
+    constexpr binary_extension(const T& v) : _value(v) {}
+    constexpr binary_extension(T&& v) : _value(std::move(v)) {}
+
+    constexpr bool has_value() const { return _value.has_value(); }
+
+    constexpr T& value() {
+        check(has_value(), "cannot get value of empty binary_extension");
+        return *_value;
+    }
+    constexpr const T& value() const {
+        check(has_value(), "cannot get value of empty binary_extension");
+        return *_value;
+    }
+
+    constexpr T value_or(const T& def) const { return _value.value_or(def); }
+    constexpr T& operator*() { return value(); }
+    constexpr const T& operator*() const { return value(); }
+    constexpr T* operator->() { return &value(); }
+    constexpr const T* operator->() const { return &value(); }
+
+    template <typename... Args>
+    T& emplace(Args&&... args) { return _value.emplace(std::forward<Args>(args)...); }
+    void reset() { _value.reset(); }
+
+private:
+    std::optional<T> _value;
+};
+
+} // namespace eosio
@@ -0,0 +1,55 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <eosio/fixed_bytes.hpp>
+#include <eosio/mock.hpp>
+
+#include <openssl/sha.h>
+
+#include <cstdint>
+#include <string>
+
+namespace eosio {
+
+inline checksum256 sha256(const char* data, uint32_t length) {
+    std::array<uint8_t, 32> digest;
+    SHA256(reinterpret_cast<const unsigned char*>(data), length, digest.data());
+    return checksum256(digest);
+}
+
+inline void assert_sha256(const char* data, uint32_t length, const checksum256& hash) {
+    check(sha256(data, length) == hash, "hash mismatch");
+}
+
+// The WAX intrinsic; the mock delegates to mock::rsa_verifier so benchmarks
+// can choose between a stub and a real OpenSSL verification
+inline bool verify_rsa_sha256_sig(const void* message,
+                                  size_t message_len,
+                                  const std::string& signature,
+                                  const std::string& exponent,
+                                  const std::string& modulus) {
+    return mock::rsa_verifier(message, message_len, signature, exponent, modulus);
+}
+
+} // namespace eosio
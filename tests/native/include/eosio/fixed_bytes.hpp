@@ -0,0 +1,58 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace eosio {
+
+class checksum256 {
+public:
+    checksum256() { _data.fill(0); }
+    explicit checksum256(const std::array<uint8_t, 32>& bytes) : _data(bytes) {}
+
+    std::array<uint8_t, 32> extract_as_byte_array() const { return _data; }
+    const uint8_t* data() const { return _data.data(); }
+    uint8_t* data() { return _data.data(); }
+    static constexpr size_t size() { return 32; }
+
+    friend bool operator==(const checksum256& a, const checksum256& b) { return a._data == b._data; }
+    friend bool operator!=(const checksum256& a, const checksum256& b) { return a._data != b._data; }
+    friend bool operator<(const checksum256& a, const checksum256& b) { return a._data < b._data; }
+
+private:
+    std::array<uint8_t, 32> _data;
+};
+
+// printed in hex like the CDT checksum256::print
+inline std::ostream& operator<<(std::ostream& os, const checksum256& value) {
+    static constexpr char hex_digits[] = "0123456789abcdef";
+    for (uint8_t byte : value.extract_as_byte_array())
+        os << hex_digits[byte >> 4] << hex_digits[byte & 0xF];
+    return os;
+}
+
+} // namespace eosio
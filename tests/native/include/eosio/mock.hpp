@@ -0,0 +1,159 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+// Global state behind the in-memory stand-ins for the chain intrinsics.
+// Tests and benchmarks drive it directly, e.g. to grant authorities or
+// advance the block time.
+
+#include <eosio/check.hpp>
+#include <eosio/name.hpp>
+#include <eosio/time.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace eosio {
+
+struct permission_level {
+    permission_level() = default;
+    permission_level(name a, name p) : actor(a), permission(p) {}
+
+    name actor;
+    name permission;
+
+    friend bool operator<(const permission_level& a, const permission_level& b) {
+        return std::tie(a.actor, a.permission) < std::tie(b.actor, b.permission);
+    }
+    friend bool operator==(const permission_level& a, const permission_level& b) {
+        return a.actor == b.actor && a.permission == b.permission;
+    }
+};
+
+namespace mock {
+
+    struct sent_action {
+        name account;
+        name action;
+        std::vector<permission_level> authorization;
+    };
+
+    // a multi_index table, its rows are only known to the multi_index type
+    struct table_slot {
+        std::shared_ptr<void> data;
+        std::function<size_t()> rows;
+    };
+
+    struct state {
+        // when empty every authority check passes
+        std::set<permission_level> auths;
+        bool check_auths = false;
+        std::set<name> accounts;
+        bool check_accounts = false;
+
+        time_point now = time_point(seconds(1577836800));
+        uint32_t tapos_block_num = 1;
+        uint32_t tapos_block_prefix = 0x5eed5eed;
+
+        std::vector<sent_action> sent_actions;
+        std::vector<name> recipients;
+        bool record_actions = false;
+        uint64_t actions_sent = 0;
+        uint64_t notifications = 0;
+
+        std::vector<char> return_value;
+
+        // every multi_index table, by (code, scope, table name)
+        std::map<std::tuple<uint64_t, uint64_t, uint64_t>, table_slot> tables;
+    };
+
+    inline state& chain() {
+        static state s;
+        return s;
+    }
+
+    inline void reset() { chain() = state(); }
+
+    // number of rows of a table, 0 when it was never opened
+    inline size_t table_rows(name code, uint64_t scope, name table) {
+        const auto& tables = chain().tables;
+        auto it = tables.find(std::make_tuple(code.value, scope, table.value));
+        return it != tables.end() ? it->second.rows() : 0;
+    }
+
+    using rsa_verifier_type = std::function<bool(const void*, size_t, const std::string&, const std::string&, const std::string&)>;
+
+    inline rsa_verifier_type rsa_verifier = [](const void*, size_t, const std::string&, const std::string&, const std::string&) {
+        return true;
+    };
+
+} // namespace mock
+
+inline bool has_auth(name n) {
+    const auto& c = mock::chain();
+    if (!c.check_auths)
+        return true;
+    for (const auto& auth : c.auths) {
+        if (auth.actor == n)
+            return true;
+    }
+    return false;
+}
+
+inline void require_auth(name n) {
+    check(has_auth(n), "missing authority of " + n.to_string());
+}
+
+inline void require_auth(const permission_level& level) {
+    const auto& c = mock::chain();
+    check(!c.check_auths || c.auths.count(level) > 0,
+          "missing authority of " + level.actor.to_string() + "/" + level.permission.to_string());
+}
+
+inline bool is_account(name n) {
+    const auto& c = mock::chain();
+    return !c.check_accounts || c.accounts.count(n) > 0;
+}
+
+inline void require_recipient(name notify_account) {
+    auto& c = mock::chain();
+    ++c.notifications;
+    if (c.record_actions)
+        c.recipients.push_back(notify_account);
+}
+
+template <typename... Remaining>
+void require_recipient(name notify_account, Remaining... remaining_accounts) {
+    require_recipient(notify_account);
+    require_recipient(remaining_accounts...);
+}
+
+
+} // namespace eosio
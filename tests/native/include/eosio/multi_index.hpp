@@ -0,0 +1,338 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+// In-memory stand-in for eosio::multi_index: rows live in a std::map keyed by
+// primary key, and each secondary index is an ordered map of (key, primary key).
+// Tables are shared by (code, scope, table name) like on chain.
+
+#include <eosio/check.hpp>
+#include <eosio/fixed_bytes.hpp>
+#include <eosio/mock.hpp>
+#include <eosio/name.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace eosio {
+
+constexpr static inline name same_payer{};
+
+template <class Class, typename Type, Type (Class::*PtrToMemberFunction)() const>
+struct const_mem_fun {
+    using result_type = std::remove_cv_t<std::remove_reference_t<Type>>;
+
+    result_type operator()(const Class& x) const { return (x.*PtrToMemberFunction)(); }
+};
+
+template <name::raw IndexName, typename Extractor>
+struct indexed_by {
+    static constexpr uint64_t index_name = static_cast<uint64_t>(IndexName);
+    using extractor_type = Extractor;
+    using key_type = typename Extractor::result_type;
+};
+
+namespace mock {
+
+    template <typename T, typename... Indices>
+    struct table_data {
+        std::map<uint64_t, T> rows;
+        std::tuple<std::map<std::pair<typename Indices::key_type, uint64_t>, const T*>...> indices;
+    };
+
+    template <typename Data>
+    std::shared_ptr<Data> open_table(uint64_t code, uint64_t scope, uint64_t table) {
+        auto& slot = chain().tables[std::make_tuple(code, scope, table)];
+        if (!slot.data) {
+            auto data = std::make_shared<Data>();
+            slot.data = data;
+            slot.rows = [rows = &data->rows] { return rows->size(); };
+        }
+        return std::static_pointer_cast<Data>(slot.data);
+    }
+
+} // namespace mock
+
+template <name::raw TableName, typename T, typename... Indices>
+class multi_index {
+    using data_type = mock::table_data<T, Indices...>;
+    using row_map = std::map<uint64_t, T>;
+
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = const T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+
+        const T& operator*() const { return _it->second; }
+        const T* operator->() const { return &_it->second; }
+
+        const_iterator& operator++() { ++_it; return *this; }
+        const_iterator operator++(int) { auto tmp = *this; ++_it; return tmp; }
+        const_iterator& operator--() { --_it; return *this; }
+        const_iterator operator--(int) { auto tmp = *this; --_it; return tmp; }
+
+        friend bool operator==(const const_iterator& a, const const_iterator& b) { return a._it == b._it; }
+        friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a._it != b._it; }
+
+    private:
+        friend class multi_index;
+        explicit const_iterator(typename row_map::const_iterator it) : _it(it) {}
+
+        typename row_map::const_iterator _it;
+    };
+
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    template <size_t N>
+    class index {
+        using index_def = std::tuple_element_t<N, std::tuple<Indices...>>;
+        using key_type = typename index_def::key_type;
+        using map_type = std::map<std::pair<key_type, uint64_t>, const T*>;
+
+    public:
+        class const_iterator {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = const T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T*;
+            using reference = const T&;
+
+            const_iterator() = default;
+
+            const T& operator*() const { return *_it->second; }
+            const T* operator->() const { return _it->second; }
+
+            const_iterator& operator++() { ++_it; return *this; }
+            const_iterator operator++(int) { auto tmp = *this; ++_it; return tmp; }
+            const_iterator& operator--() { --_it; return *this; }
+            const_iterator operator--(int) { auto tmp = *this; --_it; return tmp; }
+
+            friend bool operator==(const const_iterator& a, const const_iterator& b) { return a._it == b._it; }
+            friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a._it != b._it; }
+
+        private:
+            friend class index;
+            explicit const_iterator(typename map_type::const_iterator it) : _it(it) {}
+
+            typename map_type::const_iterator _it;
+        };
+
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        explicit index(multi_index* multidx) : _multidx(multidx) {}
+
+        const_iterator begin() const { return const_iterator(map().begin()); }
+        const_iterator end() const { return const_iterator(map().end()); }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+        const_iterator lower_bound(const key_type& key) const {
+            return const_iterator(map().lower_bound(std::make_pair(key, uint64_t(0))));
+        }
+
+        const_iterator upper_bound(const key_type& key) const {
+            return const_iterator(map().upper_bound(std::make_pair(key, std::numeric_limits<uint64_t>::max())));
+        }
+
+        const_iterator find(const key_type& key) const {
+            auto itr = lower_bound(key);
+            if (itr == end() || itr._it->first.first != key)
+                return end();
+            return itr;
+        }
+
+        const_iterator require_find(const key_type& key, const char* error_msg = "unable to find secondary key") const {
+            auto itr = find(key);
+            check(itr != end(), error_msg);
+            return itr;
+        }
+
+        const T& get(const key_type& key, const char* error_msg = "unable to find secondary key") const {
+            return *require_find(key, error_msg);
+        }
+
+        const_iterator iterator_to(const T& obj) const {
+            return const_iterator(map().find(std::make_pair(typename index_def::extractor_type()(obj), obj.primary_key())));
+        }
+
+        template <typename Lambda>
+        void modify(const_iterator itr, name payer, Lambda&& updater) {
+            _multidx->modify(*itr, payer, std::forward<Lambda>(updater));
+        }
+
+        const_iterator erase(const_iterator itr) {
+            check(itr != end(), "cannot pass end iterator to erase");
+            auto next = itr;
+            ++next;
+            _multidx->erase(*itr);
+            return next;
+        }
+
+        static constexpr eosio::name index_name() { return eosio::name(index_def::index_name); }
+
+    private:
+        map_type& map() const { return std::get<N>(_multidx->_data->indices); }
+
+        multi_index* _multidx;
+    };
+
+    multi_index(name code, uint64_t scope)
+        : _code(code)
+        , _scope(scope)
+        , _data(mock::open_table<data_type>(code.value, scope, static_cast<uint64_t>(TableName))) {}
+
+    name get_code() const { return _code; }
+    uint64_t get_scope() const { return _scope; }
+
+    const_iterator begin() const { return const_iterator(_data->rows.begin()); }
+    const_iterator end() const { return const_iterator(_data->rows.end()); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    const_iterator lower_bound(uint64_t primary) const { return const_iterator(_data->rows.lower_bound(primary)); }
+    const_iterator upper_bound(uint64_t primary) const { return const_iterator(_data->rows.upper_bound(primary)); }
+
+    uint64_t available_primary_key() const {
+        return _data->rows.empty() ? 0 : _data->rows.rbegin()->first + 1;
+    }
+
+    template <name::raw IndexName>
+    auto get_index() {
+        constexpr size_t n = index_number<IndexName>();
+        static_assert(n < sizeof...(Indices), "name provided is not the name of any secondary index within multi_index");
+        return index<n>(this);
+    }
+
+    template <name::raw IndexName>
+    auto get_index() const {
+        return const_cast<multi_index*>(this)->template get_index<IndexName>();
+    }
+
+    const_iterator iterator_to(const T& obj) const { return find(obj.primary_key()); }
+
+    const_iterator find(uint64_t primary) const { return const_iterator(_data->rows.find(primary)); }
+
+    const_iterator require_find(uint64_t primary, const char* error_msg = "unable to find key") const {
+        auto itr = find(primary);
+        check(itr != end(), error_msg);
+        return itr;
+    }
+
+    const T& get(uint64_t primary, const char* error_msg = "unable to find key") const {
+        return *require_find(primary, error_msg);
+    }
+
+    template <typename Lambda>
+    const_iterator emplace(name payer, Lambda&& constructor) {
+        check(payer != name(), "must specify a valid account to pay for new record");
+
+        T obj{};
+        constructor(obj);
+        const uint64_t pk = obj.primary_key();
+        check(_data->rows.find(pk) == _data->rows.end(),
+              "could not insert object, most likely a uniqueness constraint was violated");
+
+        auto it = _data->rows.emplace(pk, std::move(obj)).first;
+        add_secondary(it->second, std::index_sequence_for<Indices...>());
+        return const_iterator(it);
+    }
+
+    template <typename Lambda>
+    void modify(const_iterator itr, name payer, Lambda&& updater) {
+        check(itr != end(), "cannot pass end iterator to modify");
+        modify(*itr, payer, std::forward<Lambda>(updater));
+    }
+
+    template <typename Lambda>
+    void modify(const T& obj, name, Lambda&& updater) {
+        auto& mutable_obj = const_cast<T&>(obj);
+        const uint64_t pk = obj.primary_key();
+
+        remove_secondary(obj, std::index_sequence_for<Indices...>());
+        updater(mutable_obj);
+        check(pk == mutable_obj.primary_key(), "updater cannot change primary key when modifying an object");
+        add_secondary(obj, std::index_sequence_for<Indices...>());
+    }
+
+    const_iterator erase(const_iterator itr) {
+        check(itr != end(), "cannot pass end iterator to erase");
+        auto next = itr;
+        ++next;
+        erase(*itr);
+        return next;
+    }
+
+    void erase(const T& obj) {
+        const uint64_t pk = obj.primary_key();
+        remove_secondary(obj, std::index_sequence_for<Indices...>());
+        _data->rows.erase(pk);
+    }
+
+private:
+    template <name::raw IndexName>
+    static constexpr size_t index_number() {
+        constexpr uint64_t names[] = {static_cast<uint64_t>(IndexName), Indices::index_name...};
+        for (size_t i = 1; i < sizeof(names) / sizeof(names[0]); ++i) {
+            if (names[i] == names[0])
+                return i - 1;
+        }
+        return sizeof...(Indices);
+    }
+
+    template <size_t... I>
+    void add_secondary(const T& obj, std::index_sequence<I...>) {
+        (std::get<I>(_data->indices).emplace(
+            std::make_pair(typename std::tuple_element_t<I, std::tuple<Indices...>>::extractor_type()(obj), obj.primary_key()),
+            &obj), ...);
+    }
+
+    template <size_t... I>
+    void remove_secondary(const T& obj, std::index_sequence<I...>) {
+        (std::get<I>(_data->indices).erase(
+            std::make_pair(typename std::tuple_element_t<I, std::tuple<Indices...>>::extractor_type()(obj), obj.primary_key())), ...);
+    }
+
+    name _code;
+    uint64_t _scope;
+    std::shared_ptr<data_type> _data;
+};
+
+} // namespace eosio
@@ -0,0 +1,87 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// the CDT makes the 128 bits integers of clang available under these names
+using uint128_t = unsigned __int128;
+using int128_t = __int128;
+
+namespace eosio {
+
+// In-memory stand-in for the CDT eosio::name, with the same base32 encoding
+struct name {
+    enum class raw : uint64_t {};
+
+    uint64_t value = 0;
+
+    constexpr name() = default;
+    constexpr explicit name(uint64_t v) : value(v) {}
+    constexpr explicit name(raw r) : value(static_cast<uint64_t>(r)) {}
+    constexpr explicit name(std::string_view str) {
+        int i = 0;
+        for (; i < 12 && i < static_cast<int>(str.size()); ++i) {
+            value |= (char_to_value(str[i]) & 0x1f) << (64 - 5 * (i + 1));
+        }
+        if (i < static_cast<int>(str.size()) && i == 12) {
+            value |= char_to_value(str[12]) & 0x0f;
+        }
+    }
+
+    static constexpr uint64_t char_to_value(char c) {
+        if (c == '.')
+            return 0;
+        else if (c >= '1' && c <= '5')
+            return (c - '1') + 1;
+        else if (c >= 'a' && c <= 'z')
+            return (c - 'a') + 6;
+        return 0;
+    }
+
+    constexpr operator raw() const { return raw(value); }
+    constexpr explicit operator bool() const { return value != 0; }
+
+    std::string to_string() const {
+        static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+        std::string str(13, '.');
+        uint64_t tmp = value;
+        for (uint32_t i = 0; i <= 12; ++i) {
+            char c = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+            str[12 - i] = c;
+            tmp >>= (i == 0 ? 4 : 5);
+        }
+        auto last = str.find_last_not_of('.');
+        return str.substr(0, last == std::string::npos ? 0 : last + 1);
+    }
+
+    friend constexpr bool operator==(const name& a, const name& b) { return a.value == b.value; }
+    friend constexpr bool operator!=(const name& a, const name& b) { return a.value != b.value; }
+    friend constexpr bool operator<(const name& a, const name& b) { return a.value < b.value; }
+};
+
+} // namespace eosio
+
+constexpr eosio::name operator""_n(const char* s, std::size_t n) { return eosio::name(std::string_view(s, n)); }
@@ -0,0 +1,61 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <iostream>
+#include <string>
+
+namespace eosio {
+
+namespace mock {
+    // console output is discarded unless a test or benchmark turns it on
+    inline bool print_enabled = false;
+}
+
+template <typename... Args>
+void print(Args&&... args) {
+    if (mock::print_enabled)
+        (std::cout << ... << args);
+}
+
+template <typename Arg, typename... Args>
+void print_f(const char* fmt, Arg&& arg, Args&&... args) {
+    if (!mock::print_enabled)
+        return;
+    while (*fmt && *fmt != '%')
+        std::cout << *fmt++;
+    if (*fmt == '%') {
+        std::cout << arg;
+        if constexpr (sizeof...(args) > 0)
+            print_f(fmt + 1, std::forward<Args>(args)...);
+        else
+            std::cout << (fmt + 1);
+    }
+}
+
+inline void print_f(const char* fmt) {
+    if (mock::print_enabled)
+        std::cout << fmt;
+}
+
+} // namespace eosio
@@ -0,0 +1,93 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+
+namespace eosio {
+
+class microseconds {
+public:
+    explicit constexpr microseconds(int64_t c = 0) : _count(c) {}
+    constexpr int64_t count() const { return _count; }
+    constexpr int64_t to_seconds() const { return _count / 1000000; }
+
+    friend constexpr microseconds operator+(const microseconds& l, const microseconds& r) { return microseconds(l._count + r._count); }
+    friend constexpr microseconds operator-(const microseconds& l, const microseconds& r) { return microseconds(l._count - r._count); }
+    friend constexpr bool operator<(const microseconds& l, const microseconds& r) { return l._count < r._count; }
+    friend constexpr bool operator<=(const microseconds& l, const microseconds& r) { return l._count <= r._count; }
+    friend constexpr bool operator>(const microseconds& l, const microseconds& r) { return l._count > r._count; }
+    friend constexpr bool operator>=(const microseconds& l, const microseconds& r) { return l._count >= r._count; }
+    friend constexpr bool operator==(const microseconds& l, const microseconds& r) { return l._count == r._count; }
+    friend constexpr bool operator!=(const microseconds& l, const microseconds& r) { return l._count != r._count; }
+
+    int64_t _count;
+};
+
+inline constexpr microseconds seconds(int64_t s) { return microseconds(s * 1000000); }
+inline constexpr microseconds milliseconds(int64_t s) { return microseconds(s * 1000); }
+inline constexpr microseconds minutes(int64_t m) { return seconds(60 * m); }
+inline constexpr microseconds hours(int64_t h) { return minutes(60 * h); }
+inline constexpr microseconds days(int64_t d) { return hours(24 * d); }
+
+class time_point {
+public:
+    explicit constexpr time_point(microseconds e = microseconds()) : elapsed(e) {}
+    constexpr const microseconds& time_since_epoch() const { return elapsed; }
+    constexpr uint32_t sec_since_epoch() const { return uint32_t(elapsed.count() / 1000000); }
+
+    friend constexpr time_point operator+(const time_point& t, const microseconds& m) { return time_point(t.elapsed + m); }
+    friend constexpr time_point operator-(const time_point& t, const microseconds& m) { return time_point(t.elapsed - m); }
+    friend constexpr microseconds operator-(const time_point& l, const time_point& r) { return l.elapsed - r.elapsed; }
+    friend constexpr bool operator<(const time_point& l, const time_point& r) { return l.elapsed < r.elapsed; }
+    friend constexpr bool operator<=(const time_point& l, const time_point& r) { return l.elapsed <= r.elapsed; }
+    friend constexpr bool operator>(const time_point& l, const time_point& r) { return l.elapsed > r.elapsed; }
+    friend constexpr bool operator>=(const time_point& l, const time_point& r) { return l.elapsed >= r.elapsed; }
+    friend constexpr bool operator==(const time_point& l, const time_point& r) { return l.elapsed == r.elapsed; }
+    friend constexpr bool operator!=(const time_point& l, const time_point& r) { return l.elapsed != r.elapsed; }
+
+    microseconds elapsed;
+};
+
+class time_point_sec {
+public:
+    constexpr time_point_sec() : utc_seconds(0) {}
+    constexpr explicit time_point_sec(uint32_t seconds) : utc_seconds(seconds) {}
+    constexpr time_point_sec(const time_point& t) : utc_seconds(uint32_t(t.time_since_epoch().count() / 1000000ll)) {}
+
+    constexpr uint32_t sec_since_epoch() const { return utc_seconds; }
+    constexpr operator time_point() const { return time_point(eosio::seconds(utc_seconds)); }
+
+    friend constexpr time_point_sec operator+(const time_point_sec& t, const microseconds& m) { return time_point(t) + m; }
+    friend constexpr time_point_sec operator-(const time_point_sec& t, const microseconds& m) { return time_point(t) - m; }
+    friend constexpr bool operator<(const time_point_sec& l, const time_point_sec& r) { return l.utc_seconds < r.utc_seconds; }
+    friend constexpr bool operator<=(const time_point_sec& l, const time_point_sec& r) { return l.utc_seconds <= r.utc_seconds; }
+    friend constexpr bool operator>(const time_point_sec& l, const time_point_sec& r) { return l.utc_seconds > r.utc_seconds; }
+    friend constexpr bool operator>=(const time_point_sec& l, const time_point_sec& r) { return l.utc_seconds >= r.utc_seconds; }
+    friend constexpr bool operator==(const time_point_sec& l, const time_point_sec& r) { return l.utc_seconds == r.utc_seconds; }
+    friend constexpr bool operator!=(const time_point_sec& l, const time_point_sec& r) { return l.utc_seconds != r.utc_seconds; }
+
+    uint32_t utc_seconds;
+};
+
+} // namespace eosio
@@ -17,6 +17,12 @@ class RSASigning {
         }
         return this.key.sign(this.encodeNumber(signing_value), 'hex');
     };
+
+    // jobs whose signing value was derived by the contract sign it along with the job id
+    generateDerivedRandomNumber(signing_value, job_id) {
+        const message = Buffer.concat([this.encodeNumber(signing_value), this.encodeNumber(job_id)]);
+        return this.key.sign(message, 'hex');
+    };
 }
 
 module.exports = {
@@ -10,6 +10,7 @@ const {
 
 const crypto = require("crypto");
 const fs = require('fs');
+const NodeRSA = require('node-rsa');
 const { RSASigning } = require('./rsaSigning.js');
 
 function stringHashToNum(str) {
@@ -38,6 +39,11 @@ function getRandomInt(max) {
   return Math.floor(Math.random() * max);
 }
 
+// keys are stored as bytes, so their hex form has an even number of digits
+function keyBytes(hex) {
+  return hex.length % 2 === 0 ? hex : '0' + hex;
+}
+
 describe('test orng smart contract', () => {
   let systemContract = "eosio";
   let orngContract = "orng.test";
@@ -66,6 +72,83 @@ describe('test orng smart contract', () => {
   const modulus3 = "b338fddedf4bfee5eeaf78c91b246d0d53022aeed6d02ad02e186bc9897bcfee5b80115a0e3ac1aee6a967d04eec3fe9b0301ca1780fcb78255bdbf50a714bdb82fe10f043e00db8228cc4ff9ec284ebd2d77c99fde054a118f2a76bec6a04cd610ad4f338073ce2bf2e72cb671caa876eff87fb637e9da9aa06ebc6a4065cb92c3d14e93790afcdebcb3a473bc28afc7bb4080f02592f03ddb0c587280bacbdd8957d899fb5a0acedf12d66235bc7d16998542e27922fd3b0031982fa16f046336ddfca8e1e247ce424d9dad5220300b6e40742520343eac016f2018fb482b4c270f9f39ee9f2af60cd424941b2dcdda5d128210db9d2349b2cb7e62376ca61ed639869f1a607c9ae244417f8940ab271671726db470750e6b4122a3208ad7fa2cdfecbb2d3f7c23f3efa2928581617342772d91eb61af999116fa47127675738403390750697beaff2c4ff3451f2b160b2ee79d38afab1ad8fe88e1b00e310cf3a7f9ba8c266f30bc94097d0fc32e448830ac8b8083c7c80b26ece12cf67c63b8b8249a80d6ce3e04921515533ab1f9e1a68b4db9945df8c6171fff90947030c88863b454152def34331028d42df8894da9662a4958ba4bfea7aee6a4ae998cf5df86741b34da0fb45a8382384430a541b8b25ef05f88de06512a5f031a4066bc5a21c85ac598b4a93f43ac34c8e9694635227eecd425130f2f1a3ddd6f8f9";
   const privateKey3 = fs.readFileSync('./tests/resources/test_rsa_4096_priv_3.pem', 'utf8');
   const modulus3Id = stringHashToNum(crypto.createHash("sha256").update(modulus2).digest("hex"));
+  // private keys by key id, keys registered by the tests are added as they go
+  const signingKeys = { 0: privateKey0, 1: privateKey1, 2: privateKey2, 3: privateKey3 };
+
+  async function registerGeneratedKey() {
+    const pubconfig_tbl = await getTableRows(
+      orngContract,
+      "pubconfig.a",
+      orngContract
+    );
+    const id = pubconfig_tbl[0].available_key_counter;
+    const { privateKey } = crypto.generateKeyPairSync('rsa', {
+      modulusLength: 2048,
+      publicKeyEncoding: { type: 'pkcs1', format: 'pem' },
+      privateKeyEncoding: { type: 'pkcs1', format: 'pem' },
+    });
+    const { n, e } = new NodeRSA(privateKey).exportKey('components-public');
+    await genericAction(
+      orngContract,
+      "setsigpubkey",
+      {
+        id,
+        exponent: e.toString(16),
+        modulus: n.toString('hex').replace(/^0+/, '')
+      },
+      [{
+        actor: orngOracle,
+        permission: "active"
+      }]
+    );
+    signingKeys[id] = privateKey;
+    return id;
+  }
+
+  async function requestJobs(count, assoc_id) {
+    for (let i = 0; i < count; i++) {
+      await genericAction(
+        orngContract,
+        "requestrand",
+        {
+          assoc_id: assoc_id + i,
+          signing_value: getRandomInt(123456789),
+          caller: dappContract
+        },
+        [{
+          actor: dappContract,
+          permission: "active"
+        }]
+      );
+    }
+    const jobs_tbl = await getTableRows(
+      orngContract,
+      "jobs.a",
+      orngContract
+    );
+    return jobs_tbl.slice(-count);
+  }
+
+  // stream id, seq and seed as little-endian uint64, as setstreamrnd verifies them
+  function signStreamValue(stream, seq) {
+    const message = Buffer.alloc(24);
+    message.writeBigUInt64LE(BigInt(stream.id), 0);
+    message.writeBigUInt64LE(BigInt(seq), 8);
+    message.writeBigUInt64LE(BigInt(stream.seed), 16);
+    return new NodeRSA(signingKeys[stream.key_id]).sign(message, 'hex');
+  }
+
+  // signs the jobs read from jobs.a with the key recorded on each of them
+  async function signJobs(jobs) {
+    return jobs.map(job => {
+      const rsaSigning = new RSASigning(signingKeys[job.key_id]);
+      const random_value = job.derived
+        ? rsaSigning.generateDerivedRandomNumber(job.signing_value, job.id)
+        : rsaSigning.generateRandomNumber(job.signing_value);
+      return { first: job.id, second: random_value };
+    });
+  }
+
   beforeAll(async () => {
     jest.setTimeout(10000);
 
@@ -87,8 +170,8 @@ describe('test orng smart contract', () => {
 
     await setContract(
       dappContract,
-      'tests/contracts/randreceiver.wasm',
-      'tests/contracts/randreceiver.abi'
+      'build/wax.orng.tests.randreceiver.wasm',
+      'build/wax.orng.tests.randreceiver.abi'
     );
 
     await updateAuth(orngContract, `active`, `owner`, {
@@ -157,6 +240,20 @@ describe('test orng smart contract', () => {
       }]
     );
 
+    // the legacy tests below check the signing values recorded under self scope
+    await genericAction(
+      orngContract,
+      "setv1compat",
+      {
+        dapp: dappContract,
+        enabled: true
+      },
+      [{
+        actor: dappContract,
+        permission: "active"
+      }]
+    );
+
     // create pause permisison
     let auth = { threshold: 1, accounts: [{ permission: { actor: orngContract, permission: "active" }, weight: 1 }], keys: [{ key: TESTING_PUBLIC_KEY, weight: 1 },], waits: [] };
     await genericAction(
@@ -200,13 +297,13 @@ describe('test orng smart contract', () => {
     it("should init first signing key", async () => {
       const sigpubkey_tbl = await getTableRows(
         orngContract,
-        "sigpubkey.b",
+        "sigpubkey.c",
         orngContract
       );
       expect(sigpubkey_tbl[sigpubkey_tbl.length - 1].id).toEqual(0);
       expect(sigpubkey_tbl[sigpubkey_tbl.length - 1].pubkey_hash_id).toEqual(modulus0Id);
-      expect(sigpubkey_tbl[sigpubkey_tbl.length - 1].exponent).toEqual(exponent0);
-      expect(sigpubkey_tbl[sigpubkey_tbl.length - 1].modulus).toEqual(modulus0);
+      expect(sigpubkey_tbl[sigpubkey_tbl.length - 1].exponent).toEqual(keyBytes(exponent0));
+      expect(sigpubkey_tbl[sigpubkey_tbl.length - 1].modulus).toEqual(keyBytes(modulus0));
     });
   });
 
@@ -321,13 +418,13 @@ describe('test orng smart contract', () => {
 
       const sigpubkey_tbl = await getTableRows(
         orngContract,
-        "sigpubkey.b",
+        "sigpubkey.c",
         orngContract
       );
 
       expect(sigpubkey_tbl[sigpubkey_tbl.length - 1].id).toEqual(pubconfig_tbl[pubconfig_tbl.length - 1].available_key_counter);
-      expect(sigpubkey_tbl[sigpubkey_tbl.length - 1].exponent).toEqual(exponent1);
-      expect(sigpubkey_tbl[sigpubkey_tbl.length - 1].modulus).toEqual(modulus1);
+      expect(sigpubkey_tbl[sigpubkey_tbl.length - 1].exponent).toEqual(keyBytes(exponent1));
+      expect(sigpubkey_tbl[sigpubkey_tbl.length - 1].modulus).toEqual(keyBytes(modulus1));
     });
   });
 
@@ -912,14 +1009,14 @@ describe('test orng smart contract', () => {
 
       const current_sigpubkey_tbl = await getTableRows(
         orngContract,
-        "sigpubkey.b",
+        "sigpubkey.c",
         orngContract
       );
 
       const current_active_key_index = current_pubconfig_tbl[0].active_key_index;
       const current_active_key = current_sigpubkey_tbl.find(k => k.id === current_active_key_index);
-      expect(current_active_key.exponent).toEqual(exponent1);
-      expect(current_active_key.modulus).toEqual(modulus1);
+      expect(current_active_key.exponent).toEqual(keyBytes(exponent1));
+      expect(current_active_key.modulus).toEqual(keyBytes(modulus1));
 
       await genericAction(
         orngContract,
@@ -963,7 +1060,7 @@ describe('test orng smart contract', () => {
 
       const new_sigpubkey_tbl = await getTableRows(
         orngContract,
-        "sigpubkey.b",
+        "sigpubkey.c",
         orngContract
       );
 
@@ -971,8 +1068,8 @@ describe('test orng smart contract', () => {
       const new_active_key = new_sigpubkey_tbl.find(k => k.id === new_active_key_index);
 
       expect(new_active_key_index).toEqual(current_active_key_index + 1); // switch to next key
-      expect(new_active_key.exponent).toEqual(exponent2);
-      expect(new_active_key.modulus).toEqual(modulus2);
+      expect(new_active_key.exponent).toEqual(keyBytes(exponent2));
+      expect(new_active_key.modulus).toEqual(keyBytes(modulus2));
       expect(new_active_key.last).toEqual(current_active_key.last + 15); // last id to solve should be last id to solve of previous key plus current change_to_switch
 
       const jobs_tbl = await getTableRows(
@@ -1013,7 +1110,7 @@ describe('test orng smart contract', () => {
       );
     });
 
-    it("should throw if not found available key", async () => {
+    it("should extend the active key if not found available key", async () => {
       let current_pubconfig_tbl = await getTableRows(
         orngContract,
         "pubconfig.a",
@@ -1022,19 +1119,19 @@ describe('test orng smart contract', () => {
 
       const current_sigpubkey_tbl = await getTableRows(
         orngContract,
-        "sigpubkey.b",
+        "sigpubkey.c",
         orngContract
       );
 
       const current_active_key_index = current_pubconfig_tbl[0].active_key_index;
       const current_active_key = current_sigpubkey_tbl.find(k => k.id === current_active_key_index);
 
-      const config_tbl = await getTableRows(
+      const hotstate_tbl = await getTableRows(
         orngContract,
-        "config.a",
+        "hotstate.a",
         orngContract,
       );
-      const current_job_id = config_tbl.find(c => c.name === '9011391150661745152').value;
+      const current_job_id = hotstate_tbl[0].next_job_id;
 
       let signing_value = 30;
       let assoc_id = 30;
@@ -1056,7 +1153,7 @@ describe('test orng smart contract', () => {
         assoc_id += 1
       }
 
-      expect(genericAction(
+      await genericAction(
         orngContract,
         "requestrand",
         {
@@ -1068,7 +1165,23 @@ describe('test orng smart contract', () => {
           actor: dappContract,
           permission: "active"
         }]
-      )).rejects.toThrowError("admin: no available public-key");
+      );
+
+      const sigpubkey_tbl = await getTableRows(
+        orngContract,
+        "sigpubkey.c",
+        orngContract
+      );
+      const extended_key = sigpubkey_tbl.find(k => k.id === current_active_key_index);
+      expect(extended_key.last).toEqual(current_active_key.last + current_pubconfig_tbl[0].chance_to_switch);
+
+      const new_hotstate_tbl = await getTableRows(
+        orngContract,
+        "hotstate.a",
+        orngContract,
+      );
+      expect(new_hotstate_tbl[0].active_key_index).toEqual(current_active_key_index);
+      expect(new_hotstate_tbl[0].keys_low).toEqual(1);
     });
   });
 
@@ -1076,7 +1189,7 @@ describe('test orng smart contract', () => {
     it("should throw if clean sigvals for current active key", async () => {
       const sigpubkey_tbl = await getTableRows(
         orngContract,
-        "sigpubkey.b",
+        "sigpubkey.c",
         orngContract
       );
 
@@ -1097,7 +1210,7 @@ describe('test orng smart contract', () => {
     it("should clean sigvals", async () => {
       const sigpubkey_tbl = await getTableRows(
         orngContract,
-        "sigpubkey.b",
+        "sigpubkey.c",
         orngContract
       );
 
@@ -1570,7 +1683,7 @@ describe('test orng smart contract', () => {
         "errorlog.a",
         dapp1
       );
-      const current_active_key_index = errorlog_tbl[0].id;
+      const head = dappconfig_tbl.find(c => c.name === '6192251328782356992').value; // value of `errorlog.hd`
 
       for (let i = 0; i < +queueSizeRow.value + 2; i++) {
         await genericAction(
@@ -1593,10 +1706,12 @@ describe('test orng smart contract', () => {
         dapp1
       );
 
+      // the slots are overwritten in place, the newest error is in the slot before the head
+      const last_slot = (head + queueSizeRow.value + 1) % queueSizeRow.value;
       expect(errorlog_tbl.length).toEqual(queueSizeRow.value);
-      expect(errorlog_tbl[0].id).toEqual(current_active_key_index + 3);
-      expect(errorlog_tbl[errorlog_tbl.length - 1].id).toEqual(current_active_key_index + queueSizeRow.value + 2);
-      expect(errorlog_tbl[errorlog_tbl.length - 1].dapp).toEqual(dapp1);
+      expect(errorlog_tbl.map(e => e.id)).toEqual([...Array(queueSizeRow.value).keys()]);
+      expect(errorlog_tbl[last_slot].message).toEqual('error message ' + (queueSizeRow.value + 1));
+      expect(errorlog_tbl[last_slot].dapp).toEqual(dapp1);
 
       await genericAction(
         orngContract,
@@ -1619,26 +1734,29 @@ describe('test orng smart contract', () => {
 
       queueSizeRow = dappconfig_tbl.find(c => c.name === '6190615255492837024'); // value of `erorrlogsize`
 
-      await genericAction(
-        orngContract,
-        "dapperror",
-        {
-          job_id,
-          message: 'error message '
-        },
-        [{
-          actor: dapp1,
-          permission: "ornglog"
-        }]
-      );
+      // each error trims one of the rows left beyond the new size
+      for (let i = 0; i < 4; i++) {
+        await genericAction(
+          orngContract,
+          "dapperror",
+          {
+            job_id,
+            message: 'error message ' + i
+          },
+          [{
+            actor: dapp1,
+            permission: "ornglog"
+          }]
+        );
 
-      errorlog_tbl = await getTableRows(
-        orngContract,
-        "errorlog.a",
-        dapp1
-      );
+        errorlog_tbl = await getTableRows(
+          orngContract,
+          "errorlog.a",
+          dapp1
+        );
 
-      expect(errorlog_tbl.length).toEqual(0);
+        expect(errorlog_tbl.length).toEqual(3 - i);
+      }
 
       await genericAction(
         orngContract,
@@ -1690,5 +1808,2356 @@ describe('test orng smart contract', () => {
 
       expect(errorlog_tbl.length).toEqual(1);
     });
+
+    it("should throw if set message length without oracle permission", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "seterrmsgmax",
+          {
+            max_length: 10
+          },
+          [{
+            actor: dapp1,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("missing authority of oracle.wax");
+    });
+
+    it("should truncate long messages", async () => {
+      await genericAction(
+        orngContract,
+        "seterrmsgmax",
+        {
+          max_length: 10
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      await genericAction(
+        orngContract,
+        "dapperror",
+        {
+          job_id,
+          message: 'a very long error message'
+        },
+        [{
+          actor: dapp1,
+          permission: "ornglog"
+        }]
+      );
+
+      const errorlog_tbl = await getTableRows(
+        orngContract,
+        "errorlog.a",
+        dapp1
+      );
+
+      expect(errorlog_tbl.length).toEqual(2);
+      expect(errorlog_tbl.find(e => e.message === 'a very lon')).toBeDefined();
+    });
+  });
+
+  describe("set rand batch tests", () => {
+    it("should fulfill several jobs", async () => {
+      const jobs = await requestJobs(3, 500);
+      const results = await signJobs(jobs);
+
+      await genericAction(
+        orngContract,
+        "setrandbatch",
+        {
+          results,
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      const jobs_tbl = await getTableRows(
+        orngContract,
+        "jobs.a",
+        orngContract
+      );
+      for (const job of jobs) {
+        expect(jobs_tbl.find(j => j.id === job.id)).toBe(undefined);
+      }
+
+      const results_tbl = await getTableRows(
+        dappContract,
+        "results",
+        dappContract
+      );
+      const last_hash = crypto.createHash("sha256").update(results[results.length - 1].second).digest("hex");
+      expect(results_tbl[results_tbl.length - 1].assoc_id).toEqual(jobs[jobs.length - 1].assoc_id);
+      expect(results_tbl[results_tbl.length - 1].random_value).toEqual(last_hash);
+    });
+
+    it("throw if unauthorized account", async () => {
+      const jobs = await requestJobs(1, 510);
+      const results = await signJobs(jobs);
+
+      await expect(
+        genericAction(
+          orngContract,
+          "setrandbatch",
+          {
+            results,
+          },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("missing authority of oracle.wax");
+    });
+
+    it("should reject the whole batch if one signature is invalid", async () => {
+      const jobs = await requestJobs(2, 520);
+      const results = await signJobs(jobs);
+      results[1].second = results[0].second;
+
+      await expect(
+        genericAction(
+          orngContract,
+          "setrandbatch",
+          {
+            results,
+          },
+          [{
+            actor: orngOracle,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("Could not verify signature.");
+
+      const jobs_tbl = await getTableRows(
+        orngContract,
+        "jobs.a",
+        orngContract
+      );
+      for (const job of jobs) {
+        expect(jobs_tbl.find(j => j.id === job.id)).not.toBe(undefined);
+      }
+    });
+  });
+  describe("request rands tests", () => {
+    it("should create consecutive jobs", async () => {
+      const requests = [
+        { first: 600, second: getRandomInt(123456789) },
+        { first: 601, second: getRandomInt(123456789) },
+        { first: 602, second: getRandomInt(123456789) },
+      ];
+      await genericAction(
+        orngContract,
+        "requestrands",
+        {
+          requests,
+          caller: dappContract
+        },
+        [{
+          actor: dappContract,
+          permission: "active"
+        }]
+      );
+
+      const jobs_tbl = await getTableRows(
+        orngContract,
+        "jobs.a",
+        orngContract
+      );
+      const jobs = jobs_tbl.slice(-requests.length);
+      for (let i = 0; i < requests.length; i++) {
+        expect(jobs[i].id).toEqual(jobs[0].id + i);
+        expect(jobs[i].assoc_id).toEqual(requests[i].first);
+        expect(jobs[i].signing_value).toEqual(requests[i].second);
+        expect(jobs[i].caller).toEqual(dappContract);
+      }
+
+      const hotstate_tbl = await getTableRows(
+        orngContract,
+        "hotstate.a",
+        orngContract,
+      );
+      const next_job_id = hotstate_tbl[0].next_job_id;
+      expect(next_job_id).toEqual(jobs[jobs.length - 1].id + 1);
+    });
+
+    it("should throw if a signing value is repeated", async () => {
+      const signing_value = getRandomInt(123456789);
+      await expect(
+        genericAction(
+          orngContract,
+          "requestrands",
+          {
+            requests: [{ first: 610, second: signing_value }, { first: 611, second: signing_value }],
+            caller: dappContract
+          },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("Signing value already used");
+    });
+
+    it("should throw if requests are empty", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "requestrands",
+          {
+            requests: [],
+            caller: dappContract
+          },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("requests must not be empty");
+    });
+
+    it("should move to the next key in the middle of the block", async () => {
+      const next_key_id = await registerGeneratedKey();
+
+      let sigpubkey_tbl = await getTableRows(
+        orngContract,
+        "sigpubkey.c",
+        orngContract
+      );
+      const pubconfig_tbl = await getTableRows(
+        orngContract,
+        "pubconfig.a",
+        orngContract
+      );
+      const active_key = sigpubkey_tbl.find(k => k.id === pubconfig_tbl[0].active_key_index);
+
+      const hotstate_tbl = await getTableRows(
+        orngContract,
+        "hotstate.a",
+        orngContract,
+      );
+      const next_job_id = hotstate_tbl[0].next_job_id;
+
+      // enough values to cross the boundary of the active key
+      const requests = [];
+      for (let i = 0; i < active_key.last - next_job_id + 3; i++) {
+        requests.push({ first: 620 + i, second: getRandomInt(123456789) });
+      }
+      await genericAction(
+        orngContract,
+        "requestrands",
+        {
+          requests,
+          caller: dappContract
+        },
+        [{
+          actor: dappContract,
+          permission: "active"
+        }]
+      );
+
+      sigpubkey_tbl = await getTableRows(
+        orngContract,
+        "sigpubkey.c",
+        orngContract
+      );
+      const next_key = sigpubkey_tbl.find(k => k.id === next_key_id);
+      expect(next_key.last).toBeGreaterThan(active_key.last);
+
+      const old_signvals_tbl = await getTableRows(
+        orngContract,
+        "signvals.a",
+        active_key.pubkey_hash_id
+      );
+      const new_signvals_tbl = await getTableRows(
+        orngContract,
+        "signvals.a",
+        next_key.pubkey_hash_id
+      );
+      const last_old = requests[active_key.last - next_job_id].second;
+      const first_new = requests[active_key.last - next_job_id + 1].second;
+      expect(old_signvals_tbl.find(v => v.signing_value === last_old)).not.toBe(undefined);
+      expect(new_signvals_tbl.find(v => v.signing_value === first_new)).not.toBe(undefined);
+      expect(old_signvals_tbl.find(v => v.signing_value === first_new)).toBe(undefined);
+
+      // both halves of the block are signed by their own key
+      const jobs_tbl = await getTableRows(
+        orngContract,
+        "jobs.a",
+        orngContract
+      );
+      const results = await signJobs(jobs_tbl.slice(-requests.length));
+      await genericAction(
+        orngContract,
+        "setrandbatch",
+        {
+          results,
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+    });
+  });
+  describe("migrate keys tests", () => {
+    it("throw if unauthorized account", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "migratekeys",
+          {
+            rows_num: 10
+          },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("missing authority of oracle.wax");
+    });
+
+    it("should leave the current keys untouched", async () => {
+      const sigpubkey_tbl_before = await getTableRows(
+        orngContract,
+        "sigpubkey.c",
+        orngContract
+      );
+
+      await genericAction(
+        orngContract,
+        "migratekeys",
+        {
+          rows_num: 10
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      const sigpubkey_tbl = await getTableRows(
+        orngContract,
+        "sigpubkey.c",
+        orngContract
+      );
+      expect(sigpubkey_tbl).toEqual(sigpubkey_tbl_before);
+
+      const sigpubkey_v2_tbl = await getTableRows(
+        orngContract,
+        "sigpubkey.b",
+        orngContract
+      );
+      expect(sigpubkey_v2_tbl.length).toEqual(0);
+    });
+  });
+
+  describe("v1 compat tests", () => {
+    const dapp1 = 'dappdapp1111';
+    const dapp2 = 'dappdapp1112';
+
+    async function requestFrom(caller, signing_value) {
+      await genericAction(
+        orngContract,
+        "requestrand",
+        {
+          assoc_id: 700,
+          signing_value,
+          caller
+        },
+        [{
+          actor: caller,
+          permission: "active"
+        }]
+      );
+
+      return getTableRows(
+        orngContract,
+        "signvals.a",
+        orngContract
+      );
+    }
+
+    it("throw if unauthorized account", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "setv1compat",
+          {
+            dapp: dappContract,
+            enabled: false
+          },
+          [{
+            actor: dapp1,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("missing authority of dapp.wax");
+    });
+
+    it("should not record signing values under self scope by default", async () => {
+      const signing_value = getRandomInt(123456789);
+      const signvals_v1_tbl = await requestFrom(dapp1, signing_value);
+      expect(signvals_v1_tbl.find(r => r.signing_value === signing_value)).toBeUndefined();
+    });
+
+    it("should record signing values under self scope after opting in", async () => {
+      await genericAction(
+        orngContract,
+        "setv1compat",
+        {
+          dapp: dapp1,
+          enabled: true
+        },
+        [{
+          actor: dapp1,
+          permission: "active"
+        }]
+      );
+
+      const signing_value = getRandomInt(123456789);
+      const signvals_v1_tbl = await requestFrom(dapp1, signing_value);
+      expect(signvals_v1_tbl.find(r => r.signing_value === signing_value)).toBeDefined();
+    });
+
+    it("should stop recording after opting out by the contract", async () => {
+      await genericAction(
+        orngContract,
+        "setv1compat",
+        {
+          dapp: dapp1,
+          enabled: false
+        },
+        [{
+          actor: orngContract,
+          permission: "active"
+        }]
+      );
+
+      const signing_value = getRandomInt(123456789);
+      const signvals_v1_tbl = await requestFrom(dapp1, signing_value);
+      expect(signvals_v1_tbl.find(r => r.signing_value === signing_value)).toBeUndefined();
+    });
+
+    it("should follow the default of the contract for dapps that never set it", async () => {
+      async function setDefault(enabled) {
+        await genericAction(
+          orngContract,
+          "setv1compat",
+          {
+            dapp: orngContract,
+            enabled
+          },
+          [{
+            actor: orngContract,
+            permission: "active"
+          }]
+        );
+      }
+
+      await setDefault(true);
+      let signing_value = getRandomInt(123456789);
+      let signvals_v1_tbl = await requestFrom(dapp2, signing_value);
+      expect(signvals_v1_tbl.find(r => r.signing_value === signing_value)).toBeDefined();
+
+      // dapp1 opted out explicitly
+      signing_value = getRandomInt(123456789);
+      signvals_v1_tbl = await requestFrom(dapp1, signing_value);
+      expect(signvals_v1_tbl.find(r => r.signing_value === signing_value)).toBeUndefined();
+
+      await setDefault(false);
+      signing_value = getRandomInt(123456789);
+      signvals_v1_tbl = await requestFrom(dapp2, signing_value);
+      expect(signvals_v1_tbl.find(r => r.signing_value === signing_value)).toBeUndefined();
+    });
+
+    it("throw if unauthorized account purges", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "purgev1vals",
+          {
+            rows_num: 10
+          },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("missing authority of oracle.wax");
+    });
+
+    it("should purge the signing values not tracked by the active key", async () => {
+      const pubconfig_tbl = await getTableRows(
+        orngContract,
+        "pubconfig.a",
+        orngContract
+      );
+      const sigpubkey_tbl = await getTableRows(
+        orngContract,
+        "sigpubkey.c",
+        orngContract
+      );
+      const active_key = sigpubkey_tbl.find(k => k.id === pubconfig_tbl[0].active_key_index);
+      const active_signvals = (await getTableRows(
+        orngContract,
+        "signvals.a",
+        active_key.pubkey_hash_id
+      )).map(r => r.signing_value);
+
+      const signvals_v1_tbl_before = await getTableRows(
+        orngContract,
+        "signvals.a",
+        orngContract
+      );
+      const tracked = signvals_v1_tbl_before.filter(r => active_signvals.includes(r.signing_value));
+
+      // purge in small steps to exercise the resumable cursor
+      for (let rows_num = 5, checked = 0; checked <= signvals_v1_tbl_before.length; checked += rows_num++) {
+        await genericAction(
+          orngContract,
+          "purgev1vals",
+          {
+            rows_num
+          },
+          [{
+            actor: orngOracle,
+            permission: "active"
+          }]
+        );
+      }
+
+      const signvals_v1_tbl = await getTableRows(
+        orngContract,
+        "signvals.a",
+        orngContract
+      );
+      expect(signvals_v1_tbl).toEqual(tracked);
+    });
+  });
+
+  describe("hot state tests", () => {
+    async function getHotState() {
+      const hotstate_tbl = await getTableRows(
+        orngContract,
+        "hotstate.a",
+        orngContract
+      );
+      return hotstate_tbl[0];
+    }
+
+    it("should mirror the active key", async () => {
+      const hotstate = await getHotState();
+      const pubconfig_tbl = await getTableRows(
+        orngContract,
+        "pubconfig.a",
+        orngContract
+      );
+      const sigpubkey_tbl = await getTableRows(
+        orngContract,
+        "sigpubkey.c",
+        orngContract
+      );
+      const active_key = sigpubkey_tbl.find(k => k.id === pubconfig_tbl[0].active_key_index);
+
+      expect(hotstate.active_key_index).toEqual(active_key.id);
+      expect(hotstate.active_pubkey_hash_id).toEqual(active_key.pubkey_hash_id);
+      expect(hotstate.active_last).toEqual(active_key.last);
+      expect(hotstate.next_job_id).toBeLessThanOrEqual(active_key.last + 1);
+    });
+
+    it("should not keep the hot rows in config.a", async () => {
+      const config_tbl = await getTableRows(
+        orngContract,
+        "config.a",
+        orngContract
+      );
+      const hot_rows = ['12228826752859766784', '12228826999129551248', '9011391150661745152']; // paused, pauserequest, jobid.index
+      expect(config_tbl.filter(c => hot_rows.includes(c.name))).toEqual([]);
+    });
+
+    it("should keep the pause flags", async () => {
+      await genericAction(
+        orngContract,
+        "pauserequest",
+        {
+          paused: true,
+        },
+        [{
+          actor: orngContract,
+          permission: "pause"
+        }]
+      );
+      expect((await getHotState()).paused_request).toEqual(true);
+
+      await genericAction(
+        orngContract,
+        "pauserequest",
+        {
+          paused: false,
+        },
+        [{
+          actor: orngContract,
+          permission: "pause"
+        }]
+      );
+      const hotstate = await getHotState();
+      expect(hotstate.paused_request).toEqual(false);
+      expect(hotstate.paused).toEqual(false);
+    });
+  });
+
+  describe("bucketed signing values tests", () => {
+    let bucketed_key;
+    const signing_value = getRandomInt(123456789);
+
+    async function getActiveKey() {
+      const pubconfig_tbl = await getTableRows(
+        orngContract,
+        "pubconfig.a",
+        orngContract
+      );
+      const sigpubkey_tbl = await getTableRows(
+        orngContract,
+        "sigpubkey.c",
+        orngContract
+      );
+      return sigpubkey_tbl.find(k => k.id === pubconfig_tbl[0].active_key_index);
+    }
+
+    // requests the jobs left to the active key, so the next request moves on to the next key
+    async function exhaustActiveKey() {
+      const active_key = await getActiveKey();
+      const hotstate_tbl = await getTableRows(
+        orngContract,
+        "hotstate.a",
+        orngContract
+      );
+      const requests = [];
+      for (let i = hotstate_tbl[0].next_job_id; i <= active_key.last; i++) {
+        requests.push({ first: 800 + requests.length, second: getRandomInt(123456789) });
+      }
+      if (requests.length > 0) {
+        await genericAction(
+          orngContract,
+          "requestrands",
+          {
+            requests,
+            caller: dappContract
+          },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        );
+      }
+    }
+
+    async function requestValue(value) {
+      return genericAction(
+        orngContract,
+        "requestrand",
+        {
+          assoc_id: 810,
+          signing_value: value,
+          caller: dappContract
+        },
+        [{
+          actor: dappContract,
+          permission: "active"
+        }]
+      );
+    }
+
+    it("throw if unauthorized account", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "setbucketed",
+          {
+            from_key_id: 100
+          },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("missing authority of oracle.wax");
+    });
+
+    it("should throw if the active key has signed jobs", async () => {
+      const active_key = await getActiveKey();
+      await expect(
+        genericAction(
+          orngContract,
+          "setbucketed",
+          {
+            from_key_id: active_key.id
+          },
+          [{
+            actor: orngOracle,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("only allow switch the layout of the keys that have not signed jobs");
+    });
+
+    it("should store the signing values of the next keys in buckets", async () => {
+      bucketed_key = await registerGeneratedKey();
+      await genericAction(
+        orngContract,
+        "setbucketed",
+        {
+          from_key_id: bucketed_key
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      await exhaustActiveKey();
+      await requestValue(signing_value);
+
+      const active_key = await getActiveKey();
+      expect(active_key.id).toEqual(bucketed_key);
+
+      const signbucket_tbl = await getTableRows(
+        orngContract,
+        "signbucket.a",
+        active_key.pubkey_hash_id
+      );
+      expect(signbucket_tbl.length).toEqual(1);
+      expect(signbucket_tbl[0].signing_values).toEqual([signing_value]);
+
+      const signvals_tbl = await getTableRows(
+        orngContract,
+        "signvals.a",
+        active_key.pubkey_hash_id
+      );
+      expect(signvals_tbl.length).toEqual(0);
+    });
+
+    it("should throw if a bucketed signing value is repeated", async () => {
+      await expect(requestValue(signing_value)).rejects.toThrowError("Signing value already used");
+    });
+
+    it("should bill the buckets to the requesting dapp", async () => {
+      const rsp = await requestValue(signing_value + 1);
+      const deltas = rsp.processed.action_traces.flatMap(trace => trace.account_ram_deltas || []);
+      expect(deltas.filter(d => d.account === orngContract && d.delta > 0)).toEqual([]);
+      expect(deltas.find(d => d.account === dappContract).delta).toBeGreaterThan(0);
+    });
+
+    it("should clean the buckets of an old key", async () => {
+      const old_key = await getActiveKey();
+
+      await registerGeneratedKey();
+      await exhaustActiveKey();
+      await requestValue(signing_value);
+
+      await genericAction(
+        orngContract,
+        "cleansigvals",
+        {
+          scope: old_key.pubkey_hash_id,
+          rows_num: 5000
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      const signbucket_tbl = await getTableRows(
+        orngContract,
+        "signbucket.a",
+        old_key.pubkey_hash_id
+      );
+      expect(signbucket_tbl.length).toEqual(0);
+    });
+  });
+
+  describe("garbage collection tests", () => {
+    let jobs;
+
+    // signing value rows left in the scopes of the keys before the active one
+    async function retiredRows() {
+      const pubconfig_tbl = await getTableRows(
+        orngContract,
+        "pubconfig.a",
+        orngContract
+      );
+      const sigpubkey_tbl = await getTableRows(
+        orngContract,
+        "sigpubkey.c",
+        orngContract
+      );
+      let rows = 0;
+      for (const key of sigpubkey_tbl.filter(k => k.id < pubconfig_tbl[0].active_key_index)) {
+        rows += (await getTableRows(orngContract, "signvals.a", key.pubkey_hash_id)).length;
+        rows += (await getTableRows(orngContract, "signbucket.a", key.pubkey_hash_id)).length;
+      }
+      return rows;
+    }
+
+    async function setGcRows(rows_per_call) {
+      await genericAction(
+        orngContract,
+        "setgcrows",
+        {
+          rows_per_call
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+    }
+
+    it("throw if unauthorized account", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "setgcrows",
+          {
+            rows_per_call: 1
+          },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("missing authority of oracle.wax");
+    });
+
+    it("should erase rows of retired keys on request", async () => {
+      await setGcRows(1);
+
+      const rows_before = await retiredRows();
+      expect(rows_before).toBeGreaterThan(0);
+
+      jobs = await requestJobs(1, 900);
+      expect(await retiredRows()).toEqual(rows_before - 1);
+    });
+
+    it("should collect every retired key on fulfillment", async () => {
+      await setGcRows(100000);
+
+      const results = await signJobs(jobs);
+      await genericAction(
+        orngContract,
+        "setrand",
+        {
+          job_id: results[0].first,
+          random_value: results[0].second
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      expect(await retiredRows()).toEqual(0);
+
+      const hotstate_tbl = await getTableRows(
+        orngContract,
+        "hotstate.a",
+        orngContract
+      );
+      expect(hotstate_tbl[0].gc_key_id).toEqual(hotstate_tbl[0].active_key_index);
+      expect(hotstate_tbl[0].gc_rows_per_call).toEqual(100000);
+    });
+  });
+
+  describe("multiple random values tests", () => {
+    function deriveRandomValues(signed_value, count) {
+      const values = [];
+      for (let i = 0; i < count; i++) {
+        const index = Buffer.alloc(4);
+        index.writeUInt32LE(i);
+        values.push(crypto.createHash("sha256").update(Buffer.concat([Buffer.from(signed_value), index])).digest("hex"));
+      }
+      return values;
+    }
+
+    it("should throw if count is out of range", async () => {
+      for (const count of [0, 257]) {
+        await expect(
+          genericAction(
+            orngContract,
+            "requestrand",
+            {
+              assoc_id: 1000,
+              signing_value: getRandomInt(123456789),
+              caller: dappContract,
+              count
+            },
+            [{
+              actor: dappContract,
+              permission: "active"
+            }]
+          )
+        ).rejects.toThrowError("count must be between 1 and 256");
+      }
+    });
+
+    it("should derive several random values from one signature", async () => {
+      const count = 52;
+      await genericAction(
+        orngContract,
+        "requestrand",
+        {
+          assoc_id: 1001,
+          signing_value: getRandomInt(123456789),
+          caller: dappContract,
+          count
+        },
+        [{
+          actor: dappContract,
+          permission: "active"
+        }]
+      );
+
+      const jobs_tbl = await getTableRows(
+        orngContract,
+        "jobs.a",
+        orngContract
+      );
+      const job = jobs_tbl[jobs_tbl.length - 1];
+      expect(job.count).toEqual(count);
+
+      const results = await signJobs([job]);
+      await genericAction(
+        orngContract,
+        "setrand",
+        {
+          job_id: results[0].first,
+          random_value: results[0].second
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      const results_tbl = await getTableRows(
+        dappContract,
+        "results",
+        dappContract
+      );
+      const expected = deriveRandomValues(results[0].second, count);
+      expect(results_tbl[0].assoc_id).toEqual(1001);
+      expect(results_tbl[0].random_values).toEqual(expected);
+      expect(new Set(expected).size).toEqual(count);
+    });
+
+    it("should keep a single value request on receiverand", async () => {
+      const jobs = await requestJobs(1, 1002);
+      expect(jobs[0].count).toEqual(1);
+
+      const results = await signJobs(jobs);
+      await genericAction(
+        orngContract,
+        "setrand",
+        {
+          job_id: results[0].first,
+          random_value: results[0].second
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      const results_tbl = await getTableRows(
+        dappContract,
+        "results",
+        dappContract
+      );
+      expect(results_tbl[0].assoc_id).toEqual(1002);
+      expect(results_tbl[0].random_value).toEqual(crypto.createHash("sha256").update(results[0].second).digest("hex"));
+      expect(results_tbl[0].random_values).toEqual([]);
+    });
+  });
+
+  describe("in-flight quota tests", () => {
+    const inflight_index = "8419223530717052928";
+
+    async function inflight() {
+      const dappconfig_tbl = await getTableRows(
+        orngContract,
+        "dappconfig.a",
+        dappContract
+      );
+      const row = dappconfig_tbl.find(r => r.name === inflight_index);
+      return row ? row.value : 0;
+    }
+
+    async function setInflight(max_jobs) {
+      await genericAction(
+        orngContract,
+        "setinflight",
+        {
+          dapp: dappContract,
+          max_jobs
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+    }
+
+    it("throw if unauthorized account", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "setinflight",
+          {
+            dapp: dappContract,
+            max_jobs: 1
+          },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("missing authority of oracle.wax");
+    });
+
+    it("should count the jobs in flight", async () => {
+      const before = await inflight();
+      const jobs = await requestJobs(2, 1100);
+      expect(await inflight()).toEqual(before + 2);
+
+      const results = await signJobs(jobs);
+      await genericAction(
+        orngContract,
+        "setrand",
+        {
+          job_id: results[0].first,
+          random_value: results[0].second
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+      await genericAction(
+        orngContract,
+        "killjobs",
+        {
+          job_ids: [jobs[1].id]
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+      expect(await inflight()).toEqual(before);
+    });
+
+    it("should throw if the dapp reaches its limit", async () => {
+      await setInflight((await inflight()) + 1);
+      await requestJobs(1, 1200);
+
+      await expect(
+        requestJobs(1, 1201)
+      ).rejects.toThrowError(`too many jobs in flight for ${dappContract}`);
+
+      await setInflight(0);
+      await requestJobs(1, 1202);
+    });
+
+    it("should get the depth of every dapp", async () => {
+      const rsp = await genericAction(
+        orngContract,
+        "getdepths",
+        {
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+      expect(rsp.processed.action_traces[0].return_value_data).toEqual([
+        { first: dappContract, second: await inflight() }
+      ]);
+    });
+  });
+
+  describe("priority lanes tests", () => {
+    const paidDapp = 'lanedapp1111';
+    const paidDappPayer = 'lanepayer111';
+
+    beforeAll(async () => {
+      await createAccount(paidDapp, 500000);
+      await createAccount(paidDappPayer, 500000);
+
+      await genericAction(
+        orngContract,
+        "setbwpayer",
+        {
+          payee: paidDapp,
+          payer: paidDappPayer
+        },
+        [{
+          actor: paidDapp,
+          permission: "active"
+        }]
+      );
+      await genericAction(
+        orngContract,
+        "acceptbwpay",
+        {
+          payee: paidDapp,
+          payer: paidDappPayer,
+          accepted: true
+        },
+        [{
+          actor: paidDappPayer,
+          permission: "active"
+        }]
+      );
+    });
+
+    async function getNextJobs(max_jobs) {
+      const rsp = await genericAction(
+        orngContract,
+        "getnextjobs",
+        {
+          max_jobs
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+      return rsp.processed.action_traces[0].return_value_data;
+    }
+
+    it("throw if unauthorized account", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "setlaneweight",
+          {
+            paid_weight: 2
+          },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("missing authority of oracle.wax");
+    });
+
+    it("should put the jobs of paid dapps in the paid lane", async () => {
+      await requestJobs(1, 1300);
+      for (let i = 0; i < 3; i++) {
+        await genericAction(
+          orngContract,
+          "requestrand",
+          {
+            assoc_id: 1310 + i,
+            signing_value: getRandomInt(123456789),
+            caller: paidDapp
+          },
+          [{
+            actor: paidDapp,
+            permission: "active"
+          }]
+        );
+      }
+
+      const paid_tbl = await getTableRows(
+        orngContract,
+        "jobs.a",
+        "lane.paid"
+      );
+      expect(paid_tbl.map(job => job.assoc_id)).toEqual([1310, 1311, 1312]);
+
+      const free_tbl = await getTableRows(
+        orngContract,
+        "jobs.a",
+        orngContract
+      );
+      expect(free_tbl.every(job => job.caller !== paidDapp)).toBe(true);
+    });
+
+    it("should serve the lanes in weighted order", async () => {
+      await genericAction(
+        orngContract,
+        "setlaneweight",
+        {
+          paid_weight: 2
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      const paid_tbl = await getTableRows(orngContract, "jobs.a", "lane.paid");
+      const free_tbl = await getTableRows(orngContract, "jobs.a", orngContract);
+      const jobs = await getNextJobs(5);
+      expect(jobs.map(job => job.id)).toEqual([
+        paid_tbl[0].id, paid_tbl[1].id, free_tbl[0].id, paid_tbl[2].id, free_tbl[1].id
+      ]);
+      expect(jobs.map(job => job.paid)).toEqual([1, 1, 0, 1, 0]);
+    });
+
+    it("should fulfill a job of the paid lane", async () => {
+      const paid_tbl = await getTableRows(orngContract, "jobs.a", "lane.paid");
+      const results = await signJobs([paid_tbl[0]]);
+      await genericAction(
+        orngContract,
+        "setrand",
+        {
+          job_id: results[0].first,
+          random_value: results[0].second
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      const paid_tbl_after = await getTableRows(orngContract, "jobs.a", "lane.paid");
+      expect(paid_tbl_after.map(job => job.assoc_id)).toEqual([1311, 1312]);
+    });
+  });
+
+  describe("stats tests", () => {
+    async function getStats() {
+      const rsp = await genericAction(
+        orngContract,
+        "getstats",
+        {
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+      return rsp.processed.action_traces[0].return_value_data;
+    }
+
+    it("should count requested and fulfilled jobs", async () => {
+      const before = await getStats();
+
+      const jobs = await requestJobs(2, 1400);
+      const results = await signJobs(jobs);
+      await genericAction(
+        orngContract,
+        "setrand",
+        {
+          job_id: results[0].first,
+          random_value: results[0].second
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      const after = await getStats();
+      expect(after.requested).toEqual(before.requested + 2);
+      expect(after.fulfilled).toEqual(before.fulfilled + 1);
+      expect(after.depth).toEqual(before.depth + 1);
+      expect(after.max_depth).toBeGreaterThanOrEqual(after.depth);
+      expect(after.latency_histogram.length).toEqual(16);
+      expect(after.latency_histogram.reduce((sum, n) => sum + n, 0)).toEqual(after.fulfilled);
+    });
+
+    it("should count the signing values of the active key", async () => {
+      const before = await getStats();
+      await requestJobs(1, 1410);
+      const after = await getStats();
+
+      const hotstate_tbl = await getTableRows(
+        orngContract,
+        "hotstate.a",
+        orngContract
+      );
+      const active = after.key_signing_values[after.key_signing_values.length - 1];
+      expect(active.first).toEqual(hotstate_tbl[0].active_key_index);
+      expect(active.second).toEqual(before.key_signing_values[before.key_signing_values.length - 1].second + 1);
+    });
+
+    it("should count killed jobs", async () => {
+      const jobs = await requestJobs(1, 1420);
+      const before = await getStats();
+      await genericAction(
+        orngContract,
+        "killjobs",
+        {
+          job_ids: [jobs[0].id]
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      const after = await getStats();
+      expect(after.killed).toEqual(before.killed + 1);
+      expect(after.depth).toEqual(before.depth - 1);
+    });
+
+    it("should count an errored job once", async () => {
+      const dapp1 = 'dappdapp1111';
+      await genericAction(
+        orngContract,
+        "requestrand",
+        {
+          assoc_id: 1430,
+          signing_value: getRandomInt(123456789),
+          caller: dapp1
+        },
+        [{
+          actor: dapp1,
+          permission: "active"
+        }]
+      );
+      const jobs_tbl = await getTableRows(
+        orngContract,
+        "jobs.a",
+        orngContract
+      );
+      const job = jobs_tbl.filter(j => j.caller === dapp1).pop();
+
+      const before = await getStats();
+      for (const message of ['error message 1', 'error message 2']) {
+        await genericAction(
+          orngContract,
+          "dapperror",
+          {
+            job_id: job.id,
+            message
+          },
+          [{
+            actor: dapp1,
+            permission: "ornglog"
+          }]
+        );
+      }
+
+      const after = await getStats();
+      expect(after.errored).toEqual(before.errored + 1);
+    });
+  });
+
+  describe("expire jobs tests", () => {
+    async function expireJobs(max_age, max_rows, notify) {
+      return genericAction(
+        orngContract,
+        "expirejobs",
+        {
+          max_age,
+          max_rows,
+          notify
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+    }
+
+    it("throw if unauthorized account", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "expirejobs",
+          {
+            max_age: 0,
+            max_rows: 1,
+            notify: false
+          },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("missing authority of oracle.wax");
+    });
+
+    it("throw if jobexpired is not called by the contract", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "jobexpired",
+          {
+            job_id: 0,
+            assoc_id: 0,
+            caller: dappContract
+          },
+          [{
+            actor: orngOracle,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError(`missing authority of ${orngContract}`);
+    });
+
+    it("should keep the jobs younger than max_age", async () => {
+      await requestJobs(1, 1500);
+      const jobs_before = await getTableRows(orngContract, "jobs.a", orngContract);
+
+      await expireJobs(3600, 100, false);
+
+      const jobs_after = await getTableRows(orngContract, "jobs.a", orngContract);
+      expect(jobs_after).toEqual(jobs_before);
+    });
+
+    // the jobs of both lanes, oldest first
+    async function allJobs() {
+      const free_tbl = await getTableRows(orngContract, "jobs.a", orngContract);
+      const paid_tbl = await getTableRows(orngContract, "jobs.a", "lane.paid");
+      return [...free_tbl, ...paid_tbl].sort((a, b) => a.id - b.id);
+    }
+
+    it("should remove the oldest jobs and notify their dapps", async () => {
+      const jobs_before = await allJobs();
+      expect(jobs_before.length).toBeGreaterThan(1);
+
+      const rsp = await expireJobs(0, 1, true);
+
+      expect(await allJobs()).toEqual(jobs_before.slice(1));
+
+      const notified = rsp.processed.action_traces[0].inline_traces
+        .filter(trace => trace.act.name === "jobexpired");
+      expect(notified.length).toEqual(1);
+      expect(notified[0].act.data.job_id).toEqual(jobs_before[0].id);
+      expect(notified[0].act.data.caller).toEqual(jobs_before[0].caller);
+    });
+
+    it("should remove the oldest jobs across the lanes", async () => {
+      await expireJobs(0, 1000, false);
+      expect(await allJobs()).toEqual([]);
+
+      // a paid job older than the free one
+      await genericAction(
+        orngContract,
+        "requestrand",
+        {
+          assoc_id: 1510,
+          signing_value: getRandomInt(123456789),
+          caller: 'lanedapp1111'
+        },
+        [{
+          actor: 'lanedapp1111',
+          permission: "active"
+        }]
+      );
+      await requestJobs(1, 1511);
+
+      await expireJobs(0, 1, false);
+
+      const jobs_after = await allJobs();
+      expect(jobs_after.map(job => job.assoc_id)).toEqual([1511]);
+    });
+  });
+
+  describe("receiver client tests", () => {
+    it("throw if the random value does not come from the orng contract", async () => {
+      await expect(
+        genericAction(
+          dappContract,
+          "receiverand",
+          {
+            assoc_id: 1600,
+            random_value: "0".repeat(64)
+          },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError(`missing authority of ${orngContract}`);
+    });
+
+    it("should roll a die from the random value", async () => {
+      const jobs = await requestJobs(1, 1601);
+      const results = await signJobs(jobs);
+      await genericAction(
+        orngContract,
+        "setrand",
+        {
+          job_id: results[0].first,
+          random_value: results[0].second
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      const results_tbl = await getTableRows(
+        dappContract,
+        "results",
+        dappContract
+      );
+      // the first word of the random value, as random_stream reads it
+      const first_word = BigInt("0x" + results_tbl[0].random_value.slice(0, 16));
+      expect(results_tbl[0].assoc_id).toEqual(1601);
+      expect(results_tbl[0].roll).toEqual(Number(1n + first_word % 6n));
+    });
+  });
+
+  describe("key staging tests", () => {
+    function generateKey() {
+      const { privateKey } = crypto.generateKeyPairSync('rsa', {
+        modulusLength: 2048,
+        publicKeyEncoding: { type: 'pkcs1', format: 'pem' },
+        privateKeyEncoding: { type: 'pkcs1', format: 'pem' },
+      });
+      const { n, e } = new NodeRSA(privateKey).exportKey('components-public');
+      return {
+        privateKey,
+        key: { first: e.toString(16), second: n.toString('hex').replace(/^0+/, '') }
+      };
+    }
+
+    it("throw if not authorized by oracle", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "setlowmark",
+          { staged_keys: 2 },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError(`missing authority of ${orngOracle}`);
+    });
+
+    it("should set several public keys at once and lower keys_low", async () => {
+      const pubconfig_tbl = await getTableRows(orngContract, "pubconfig.a", orngContract);
+      const first_id = pubconfig_tbl[0].available_key_counter;
+      const generated = [generateKey(), generateKey()];
+
+      await genericAction(
+        orngContract,
+        "setpubkeys",
+        {
+          first_id,
+          keys: generated.map(g => g.key)
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+      generated.forEach((g, i) => { signingKeys[first_id + i] = g.privateKey; });
+
+      const new_pubconfig_tbl = await getTableRows(orngContract, "pubconfig.a", orngContract);
+      expect(new_pubconfig_tbl[0].available_key_counter).toEqual(first_id + 2);
+
+      const sigpubkey_tbl = await getTableRows(orngContract, "sigpubkey.c", orngContract);
+      expect(sigpubkey_tbl.filter(k => k.id >= first_id).length).toEqual(2);
+
+      const hotstate_tbl = await getTableRows(orngContract, "hotstate.a", orngContract);
+      expect(hotstate_tbl[0].keys_low).toEqual(0);
+    });
+
+    it("should raise keys_low under the low watermark", async () => {
+      const pubconfig_tbl = await getTableRows(orngContract, "pubconfig.a", orngContract);
+      const staged_keys = pubconfig_tbl[0].available_key_counter - pubconfig_tbl[0].active_key_index - 1;
+
+      await genericAction(
+        orngContract,
+        "setlowmark",
+        { staged_keys: staged_keys + 1 },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      const hotstate_tbl = await getTableRows(orngContract, "hotstate.a", orngContract);
+      expect(hotstate_tbl[0].keys_low).toEqual(1);
+    });
+
+    it("throw if the keys do not follow the available key counter", async () => {
+      const pubconfig_tbl = await getTableRows(orngContract, "pubconfig.a", orngContract);
+
+      await expect(
+        genericAction(
+          orngContract,
+          "setpubkeys",
+          {
+            first_id: pubconfig_tbl[0].available_key_counter + 1,
+            keys: [generateKey().key]
+          },
+          [{
+            actor: orngOracle,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("make sure the next key in order");
+    });
+  });
+
+  describe("job shards tests", () => {
+    async function setShards(shards) {
+      return genericAction(
+        orngContract,
+        "setshards",
+        { shards },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+    }
+
+    async function getShardJobs(shard, max_jobs) {
+      const rsp = await genericAction(
+        orngContract,
+        "getshardjobs",
+        { shard, max_jobs },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+      return rsp.processed.action_traces[0].return_value_data;
+    }
+
+    async function setRandShard(shard, results) {
+      return genericAction(
+        orngContract,
+        "setrandshard",
+        { shard, results },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+    }
+
+    it("throw if not authorized by oracle", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "setshards",
+          { shards: 2 },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError(`missing authority of ${orngOracle}`);
+    });
+
+    it("throw if more than 16 shards", async () => {
+      await expect(setShards(17)).rejects.toThrowError("shards must be between 1 and 16");
+    });
+
+    it("should spread the next jobs over the shards", async () => {
+      await setShards(2);
+      const hotstate_tbl = await getTableRows(orngContract, "hotstate.a", orngContract);
+      expect(hotstate_tbl[0].job_shards).toEqual(2);
+      const shards_from = hotstate_tbl[0].shards_from;
+
+      await requestJobs(4, 1700);
+
+      const shard1_jobs = await getShardJobs(1, 100);
+      const new_jobs = shard1_jobs.filter(job => job.id >= shards_from);
+      expect(new_jobs.length).toEqual(2);
+      new_jobs.forEach(job => expect(job.id % 2).toEqual(1));
+    });
+
+    it("throw if the job belongs to another shard", async () => {
+      const shard1_jobs = await getShardJobs(1, 1);
+      const results = await signJobs(shard1_jobs);
+
+      await expect(setRandShard(0, results)).rejects.toThrowError("job belongs to another shard");
+    });
+
+    it("should fulfill the jobs of a shard", async () => {
+      const shard1_jobs = await getShardJobs(1, 100);
+      const results = await signJobs(shard1_jobs);
+
+      await setRandShard(1, results);
+
+      expect(await getShardJobs(1, 100)).toEqual([]);
+    });
+
+    it("should merge the lanes of all shards in getnextjobs", async () => {
+      async function getNextJobs(max_jobs) {
+        const rsp = await genericAction(
+          orngContract,
+          "getnextjobs",
+          { max_jobs },
+          [{
+            actor: orngOracle,
+            permission: "active"
+          }]
+        );
+        return rsp.processed.action_traces[0].return_value_data;
+      }
+
+      const pending = await getNextJobs(1000);
+      if (pending.length > 0) {
+        await genericAction(
+          orngContract,
+          "killjobs",
+          { job_ids: pending.map(job => job.id) },
+          [{
+            actor: orngOracle,
+            permission: "active"
+          }]
+        );
+      }
+      await genericAction(
+        orngContract,
+        "setlaneweight",
+        { paid_weight: 2 },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      // shard 0 gets three free jobs and a paid one, shard 1 as well
+      const hotstate_tbl = await getTableRows(orngContract, "hotstate.a", orngContract);
+      const first_id = hotstate_tbl[0].next_job_id;
+      await requestJobs(6, 1710);
+      for (let i = 0; i < 2; i++) {
+        await genericAction(
+          orngContract,
+          "requestrand",
+          {
+            assoc_id: 1716 + i,
+            signing_value: getRandomInt(123456789),
+            caller: 'lanedapp1111'
+          },
+          [{
+            actor: 'lanedapp1111',
+            permission: "active"
+          }]
+        );
+      }
+
+      // the paid job of shard 1 comes before the free jobs of shard 0
+      const jobs = await getNextJobs(3);
+      expect(jobs.map(job => job.id)).toEqual([first_id + 6, first_id + 7, first_id]);
+      expect(jobs.map(job => job.paid)).toEqual([1, 1, 0]);
+    });
+
+    it("should go back to a single shard once the jobs are gone", async () => {
+      const rsp = await genericAction(
+        orngContract,
+        "getnextjobs",
+        { max_jobs: 1000 },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+      const job_ids = rsp.processed.action_traces[0].return_value_data.map(job => job.id);
+      await genericAction(
+        orngContract,
+        "killjobs",
+        { job_ids },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      await setShards(1);
+      await setShards(1);
+
+      const hotstate_tbl = await getTableRows(orngContract, "hotstate.a", orngContract);
+      expect(hotstate_tbl[0].job_shards).toEqual(1);
+      expect(hotstate_tbl[0].prev_job_shards).toEqual(1);
+    });
+  });
+
+  describe("subscription tests", () => {
+    async function setStreamRand(stream_id, seq, random_value) {
+      return genericAction(
+        orngContract,
+        "setstreamrnd",
+        { stream_id, seq, random_value },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+    }
+
+    it("should register a stream paid by its caller", async () => {
+      await genericAction(
+        orngContract,
+        "subscribe",
+        {
+          caller: dappContract,
+          assoc_id: 1800,
+          period: 3600,
+          max_outstanding: 2,
+          seed: 12345
+        },
+        [{
+          actor: dappContract,
+          permission: "active"
+        }]
+      );
+
+      const streams_tbl = await getTableRows(orngContract, "streams.a", orngContract);
+      expect(streams_tbl.length).toEqual(1);
+      expect(streams_tbl[0].caller).toEqual(dappContract);
+      expect(streams_tbl[0].assoc_id).toEqual(1800);
+      expect(streams_tbl[0].next_seq).toEqual(0);
+    });
+
+    it("throw if the signature is not the stream message", async () => {
+      const streams_tbl = await getTableRows(orngContract, "streams.a", orngContract);
+      const other_stream = { ...streams_tbl[0], seed: 54321 };
+
+      await expect(setStreamRand(streams_tbl[0].id, 0, signStreamValue(other_stream, 0)))
+        .rejects.toThrowError("Could not verify signature.");
+    });
+
+    it("should deliver the due value through receiverand", async () => {
+      const streams_tbl = await getTableRows(orngContract, "streams.a", orngContract);
+      const random_value = signStreamValue(streams_tbl[0], 0);
+
+      await setStreamRand(streams_tbl[0].id, 0, random_value);
+
+      const results_tbl = await getTableRows(dappContract, "results", dappContract);
+      expect(results_tbl[0].assoc_id).toEqual(1800);
+      expect(results_tbl[0].random_value).toEqual(crypto.createHash("sha256").update(random_value).digest("hex"));
+
+      const new_streams_tbl = await getTableRows(orngContract, "streams.a", orngContract);
+      expect(new_streams_tbl[0].next_seq).toEqual(1);
+    });
+
+    it("throw if the next value is not due yet", async () => {
+      const streams_tbl = await getTableRows(orngContract, "streams.a", orngContract);
+
+      await expect(setStreamRand(streams_tbl[0].id, 1, signStreamValue(streams_tbl[0], 1)))
+        .rejects.toThrowError("stream value not due yet");
+    });
+
+    it("should remove the stream on unsubscribe by its caller", async () => {
+      const streams_tbl = await getTableRows(orngContract, "streams.a", orngContract);
+
+      await expect(
+        genericAction(
+          orngContract,
+          "unsubscribe",
+          { stream_id: streams_tbl[0].id },
+          [{
+            actor: payer,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError(`missing authority of ${dappContract}`);
+
+      await genericAction(
+        orngContract,
+        "unsubscribe",
+        { stream_id: streams_tbl[0].id },
+        [{
+          actor: dappContract,
+          permission: "active"
+        }]
+      );
+      expect(await getTableRows(orngContract, "streams.a", orngContract)).toEqual([]);
+    });
+
+    async function subscribe(period) {
+      return genericAction(
+        orngContract,
+        "subscribe",
+        {
+          caller: dappContract,
+          assoc_id: 1810,
+          period,
+          max_outstanding: 1,
+          seed: 777
+        },
+        [{
+          actor: dappContract,
+          permission: "active"
+        }]
+      );
+    }
+
+    async function setStreamCap(max_streams, min_period) {
+      return genericAction(
+        orngContract,
+        "setstreamcap",
+        { max_streams, min_period },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+    }
+
+    it("throw if unauthorized account sets the stream cap", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "setstreamcap",
+          { max_streams: 10, min_period: 1 },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("missing authority of oracle.wax");
+    });
+
+    it("throw if the period is under the minimum", async () => {
+      await setStreamCap(2, 60);
+      await expect(subscribe(59)).rejects.toThrowError("period must be at least 60 seconds");
+    });
+
+    it("throw if the dapp has too many streams", async () => {
+      await subscribe(60);
+      await subscribe(60);
+      await expect(subscribe(60)).rejects.toThrowError(`too many streams for ${dappContract}`);
+    });
+
+    it("should let the oracle close a stream", async () => {
+      const streams_tbl = await getTableRows(orngContract, "streams.a", orngContract);
+      for (const stream of streams_tbl) {
+        await genericAction(
+          orngContract,
+          "unsubscribe",
+          { stream_id: stream.id },
+          [{
+            actor: orngOracle,
+            permission: "active"
+          }]
+        );
+      }
+      expect(await getTableRows(orngContract, "streams.a", orngContract)).toEqual([]);
+
+      // closing frees the quota of the dapp
+      await subscribe(60);
+      const new_streams_tbl = await getTableRows(orngContract, "streams.a", orngContract);
+      await genericAction(
+        orngContract,
+        "unsubscribe",
+        { stream_id: new_streams_tbl[0].id },
+        [{
+          actor: dappContract,
+          permission: "active"
+        }]
+      );
+      await setStreamCap(4, 5);
+    });
+  });
+
+  describe("job feed tests", () => {
+    async function getJobFeed(cursor, max_jobs) {
+      const rsp = await genericAction(
+        orngContract,
+        "getjobfeed",
+        { cursor, max_jobs },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+      return rsp.processed.action_traces[0].return_value_data;
+    }
+
+    it("should page the jobs with their key and payer", async () => {
+      const jobs = await requestJobs(3, 1900);
+      const bwpayers_tbl = await getTableRows(orngContract, "bwpayers.a", orngContract);
+      const bwpayer = bwpayers_tbl.find(row => row.payee === dappContract && row.accepted);
+
+      const first_page = await getJobFeed(jobs[0].id, 2);
+      expect(first_page.jobs.map(job => job.id)).toEqual([jobs[0].id, jobs[1].id]);
+      expect(first_page.cursor).toEqual(jobs[1].id + 1);
+      first_page.jobs.forEach((job, i) => {
+        expect(job.signing_value).toEqual(jobs[i].signing_value);
+        expect(job.key_id).toEqual(jobs[i].key_id);
+        expect(job.caller).toEqual(dappContract);
+        expect(job.payer).toEqual(bwpayer ? bwpayer.payer : "");
+      });
+
+      const second_page = await getJobFeed(first_page.cursor, 2);
+      expect(second_page.jobs.map(job => job.id)).toEqual([jobs[2].id]);
+      expect(second_page.cursor).toEqual(jobs[2].id + 1);
+    });
+
+    it("should keep the cursor when no job is left", async () => {
+      const hotstate_tbl = await getTableRows(orngContract, "hotstate.a", orngContract);
+      const cursor = hotstate_tbl[0].next_job_id;
+
+      const page = await getJobFeed(cursor, 10);
+      expect(page.jobs).toEqual([]);
+      expect(page.cursor).toEqual(cursor);
+    });
+  });
+
+  describe("pull mode tests", () => {
+    async function setPullMode(ring_size) {
+      return genericAction(
+        orngContract,
+        "setpullmode",
+        { dapp: dappContract, ring_size },
+        [{
+          actor: dappContract,
+          permission: "active"
+        }]
+      );
+    }
+
+    async function claimRand(count) {
+      return genericAction(
+        orngContract,
+        "claimrand",
+        { dapp: dappContract, count },
+        [{
+          actor: dappContract,
+          permission: "active"
+        }]
+      );
+    }
+
+    async function getPullSequence(name) {
+      const dappconfig_tbl = await getTableRows(orngContract, "dappconfig.a", dappContract);
+      const row = dappconfig_tbl.find(r => r.name === name);
+      return row ? row.value : 0;
+    }
+
+    it("throw if not authorized by the dapp", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "setpullmode",
+          { dapp: dappContract, ring_size: 2 },
+          [{
+            actor: orngOracle,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError(`missing authority of ${dappContract}`);
+    });
+
+    it("should create the ring rows paid by the dapp", async () => {
+      await setPullMode(2);
+
+      const pullres_tbl = await getTableRows(orngContract, "pullres.a", dappContract);
+      expect(pullres_tbl.map(row => row.id)).toEqual([0, 1]);
+    });
+
+    it("should store the random value instead of calling receiverand", async () => {
+      const head = await getPullSequence("pull.head");
+      const jobs = await requestJobs(1, 2000);
+      const results = await signJobs(jobs);
+
+      const rsp = await genericAction(
+        orngContract,
+        "setrand",
+        {
+          job_id: results[0].first,
+          random_value: results[0].second
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      const inline_actions = rsp.processed.action_traces[0].inline_traces.map(trace => trace.act.name);
+      expect(inline_actions).not.toContain("receiverand");
+
+      const pullres_tbl = await getTableRows(orngContract, "pullres.a", dappContract);
+      const slot = pullres_tbl.find(row => row.seq === head);
+      expect(slot.assoc_id).toEqual(2000);
+      expect(slot.random_value).toEqual(crypto.createHash("sha256").update(results[0].second).digest("hex"));
+      expect(await getPullSequence("pull.head")).toEqual(head + 1);
+    });
+
+    it("throw if claiming more than the pending results", async () => {
+      await expect(claimRand(2)).rejects.toThrowError("count is over the pending results");
+    });
+
+    it("should store the values of a stream instead of calling receiverand", async () => {
+      await genericAction(
+        orngContract,
+        "subscribe",
+        {
+          caller: dappContract,
+          assoc_id: 2010,
+          period: 3600,
+          max_outstanding: 1,
+          seed: 6789
+        },
+        [{
+          actor: dappContract,
+          permission: "active"
+        }]
+      );
+      const streams_tbl = await getTableRows(orngContract, "streams.a", orngContract);
+      const stream = streams_tbl.find(row => row.assoc_id === 2010);
+      const random_value = signStreamValue(stream, 0);
+      const head = await getPullSequence("pull.head");
+
+      const rsp = await genericAction(
+        orngContract,
+        "setstreamrnd",
+        { stream_id: stream.id, seq: 0, random_value },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      const inline_actions = rsp.processed.action_traces[0].inline_traces.map(trace => trace.act.name);
+      expect(inline_actions).not.toContain("receiverand");
+
+      const pullres_tbl = await getTableRows(orngContract, "pullres.a", dappContract);
+      const slot = pullres_tbl.find(row => row.seq === head);
+      expect(slot.assoc_id).toEqual(2010);
+      expect(slot.random_value).toEqual(crypto.createHash("sha256").update(random_value).digest("hex"));
+
+      // leaves only the stream value pending
+      await claimRand(1);
+      await genericAction(
+        orngContract,
+        "unsubscribe",
+        { stream_id: stream.id },
+        [{
+          actor: dappContract,
+          permission: "active"
+        }]
+      );
+    });
+
+    it("should go back to receiverand once the results are claimed", async () => {
+      await expect(setPullMode(0)).rejects.toThrowError("claim the pending results first");
+
+      await claimRand(1);
+      await setPullMode(0);
+
+      expect(await getTableRows(orngContract, "pullres.a", dappContract)).toEqual([]);
+    });
+  });
+
+  describe("derived signing value tests", () => {
+    async function requestDerived(assoc_id) {
+      return genericAction(
+        orngContract,
+        "requestrand",
+        {
+          assoc_id,
+          signing_value: 0,
+          caller: dappContract
+        },
+        [{
+          actor: dappContract,
+          permission: "active"
+        }]
+      );
+    }
+
+    async function getActiveSignvals() {
+      const hotstate_tbl = await getTableRows(orngContract, "hotstate.a", orngContract);
+      return getTableRows(orngContract, "signvals.a", hotstate_tbl[0].active_pubkey_hash_id);
+    }
+
+    it("should derive unique signing values without recording them", async () => {
+      const signvals_before = await getActiveSignvals();
+
+      await requestDerived(3000);
+      await requestDerived(3001);
+
+      const jobs_tbl = await getTableRows(orngContract, "jobs.a", orngContract);
+      const jobs = jobs_tbl.slice(-2);
+      expect(jobs.map(job => job.derived)).toEqual([1, 1]);
+      expect(jobs[0].signing_value).not.toEqual(0);
+      expect(jobs[0].signing_value).not.toEqual(jobs[1].signing_value);
+      expect(await getActiveSignvals()).toHaveLength(signvals_before.length);
+    });
+
+    it("throw if the signature does not cover the job id", async () => {
+      const jobs_tbl = await getTableRows(orngContract, "jobs.a", orngContract);
+      const job = jobs_tbl[jobs_tbl.length - 1];
+      const rsaSigning = new RSASigning(signingKeys[job.key_id]);
+
+      await expect(
+        genericAction(
+          orngContract,
+          "setrand",
+          {
+            job_id: job.id,
+            random_value: rsaSigning.generateRandomNumber(job.signing_value)
+          },
+          [{
+            actor: orngOracle,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError("Could not verify signature.");
+    });
+
+    it("should fulfill the jobs signed with their job id", async () => {
+      const jobs_tbl = await getTableRows(orngContract, "jobs.a", orngContract);
+      const jobs = jobs_tbl.slice(-2);
+      const results = await signJobs(jobs);
+
+      await genericAction(
+        orngContract,
+        "setrandbatch",
+        {
+          results,
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+
+      const remaining = await getTableRows(orngContract, "jobs.a", orngContract);
+      expect(remaining.map(job => job.id)).not.toContain(jobs[0].id);
+      expect(remaining.map(job => job.id)).not.toContain(jobs[1].id);
+    });
+  });
+
+  describe("key slots tests", () => {
+    async function setKeySlots(slots) {
+      return genericAction(
+        orngContract,
+        "setkeyslots",
+        { slots },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+    }
+
+    it("throw if not authorized by oracle", async () => {
+      await expect(
+        genericAction(
+          orngContract,
+          "setkeyslots",
+          { slots: 2 },
+          [{
+            actor: dappContract,
+            permission: "active"
+          }]
+        )
+      ).rejects.toThrowError(`missing authority of ${orngOracle}`);
+    });
+
+    it("throw if the slots are out of range", async () => {
+      await expect(setKeySlots(0)).rejects.toThrowError("slots must be between 1 and 8");
+      await expect(setKeySlots(9)).rejects.toThrowError("slots must be between 1 and 8");
+    });
+
+    it("should sign the jobs of each slot with its own key", async () => {
+      await genericAction(orngContract, "setchance", { chance_to_switch: 100 }, [{ actor: orngOracle, permission: "active" }]);
+      const pubconfig_tbl = await getTableRows(orngContract, "pubconfig.a", orngContract);
+      for (let staged = pubconfig_tbl[0].available_key_counter - pubconfig_tbl[0].active_key_index - 1; staged < 2; staged++) {
+        await registerGeneratedKey();
+      }
+
+      await setKeySlots(3);
+      const hotstate_tbl = await getTableRows(orngContract, "hotstate.a", orngContract);
+      expect(hotstate_tbl[0].key_slots).toEqual(3);
+      expect(hotstate_tbl[0].extra_key_slots).toHaveLength(2);
+
+      const jobs = await requestJobs(6, 4000);
+      jobs.forEach(job => {
+        const slot = job.id % 3;
+        if (slot > 0) {
+          expect(job.key_id).toEqual(hotstate_tbl[0].extra_key_slots[slot - 1].key_id);
+        }
+        jobs.filter(other => other.id % 3 !== slot).forEach(other => {
+          expect(other.key_id).not.toEqual(job.key_id);
+        });
+      });
+
+      const results = await signJobs(jobs);
+      await genericAction(
+        orngContract,
+        "setrandbatch",
+        {
+          results,
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+      const jobs_tbl = await getTableRows(orngContract, "jobs.a", orngContract);
+      jobs.forEach(job => {
+        expect(jobs_tbl.map(row => row.id)).not.toContain(job.id);
+      });
+    });
+
+    it("should retire the keys of the removed slots", async () => {
+      const hotstate_tbl = await getTableRows(orngContract, "hotstate.a", orngContract);
+      const slot_keys = hotstate_tbl[0].extra_key_slots.map(slot => slot.key_id);
+
+      await setKeySlots(1);
+
+      const new_hotstate_tbl = await getTableRows(orngContract, "hotstate.a", orngContract);
+      expect(new_hotstate_tbl[0].key_slots).toEqual(1);
+      expect(new_hotstate_tbl[0].extra_key_slots).toEqual([]);
+      const keystats_tbl = await getTableRows(orngContract, "keystats.a", orngContract);
+      slot_keys.forEach(key_id => {
+        expect(keystats_tbl.map(row => row.key_id)).toContain(key_id);
+      });
+    });
+
+    it("should keep the jobs left to a key when resizing with jobs in flight", async () => {
+      await registerGeneratedKey();
+      const in_flight = await requestJobs(2, 4100);
+      const hotstate_tbl = await getTableRows(orngContract, "hotstate.a", orngContract);
+      const { next_job_id, active_last } = hotstate_tbl[0];
+
+      await setKeySlots(2);
+
+      // slot 0 signs the same number of jobs, one job id in two
+      const new_hotstate_tbl = await getTableRows(orngContract, "hotstate.a", orngContract);
+      const first_job_id = next_job_id + next_job_id % 2;
+      expect(new_hotstate_tbl[0].active_last).toEqual(
+        active_last >= next_job_id ? first_job_id + (active_last - next_job_id) * 2 : active_last
+      );
+
+      const jobs = in_flight.concat(await requestJobs(2, 4110));
+      const results = await signJobs(jobs);
+      await genericAction(
+        orngContract,
+        "setrandbatch",
+        {
+          results,
+        },
+        [{
+          actor: orngOracle,
+          permission: "active"
+        }]
+      );
+      const jobs_tbl = await getTableRows(orngContract, "jobs.a", orngContract);
+      jobs.forEach(job => {
+        expect(jobs_tbl.map(row => row.id)).not.toContain(job.id);
+      });
+
+      await setKeySlots(1);
+    });
   });
 });
@@ -0,0 +1,170 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "chain_api.hpp"
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+namespace orng_oracle {
+
+namespace beast = boost::beast;
+namespace http = boost::beast::http;
+using tcp = boost::asio::ip::tcp;
+
+struct chain_api::connection {
+    boost::asio::io_context io;
+    beast::tcp_stream       stream{io};
+    bool                    connected = false;
+};
+
+chain_api::chain_api(const std::string& url) : conn(std::make_unique<connection>()) {
+    const std::string scheme = "http://";
+    if (url.rfind(scheme, 0) != 0) {
+        throw std::invalid_argument("only http:// node urls are supported: " + url);
+    }
+    std::string authority = url.substr(scheme.size());
+    authority = authority.substr(0, authority.find('/'));
+    const auto colon = authority.rfind(':');
+    host = authority.substr(0, colon);
+    port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+}
+
+chain_api::~chain_api() = default;
+
+boost::property_tree::ptree chain_api::post(const std::string& target, const std::string& body) {
+    http::request<http::string_body> request{http::verb::post, target, 11};
+    request.set(http::field::host, host);
+    request.set(http::field::content_type, "application/json");
+    request.keep_alive(true);
+    request.body() = body;
+    request.prepare_payload();
+
+    http::response<http::string_body> response;
+    // a kept-alive connection closed by the node is opened again once
+    for (int attempt = 0;; ++attempt) {
+        try {
+            if (!conn->connected) {
+                tcp::resolver resolver(conn->io);
+                conn->stream.connect(resolver.resolve(host, port));
+                conn->connected = true;
+            }
+            beast::flat_buffer buffer;
+            http::write(conn->stream, request);
+            http::read(conn->stream, buffer, response);
+            if (!response.keep_alive()) {
+                beast::error_code ignored;
+                conn->stream.socket().shutdown(tcp::socket::shutdown_both, ignored);
+                conn->stream.close();
+                conn->connected = false;
+            }
+            break;
+        } catch (const beast::system_error&) {
+            conn->stream.close();
+            conn->connected = false;
+            if (attempt > 0) {
+                throw;
+            }
+            response = {};
+        }
+    }
+
+    boost::property_tree::ptree tree;
+    std::istringstream json(response.body());
+    boost::property_tree::read_json(json, tree);
+    if (response.result() != http::status::ok && response.result() != http::status::accepted) {
+        // nodeos puts the assertion message in the first detail
+        const auto details = tree.get_child_optional("error.details");
+        if (details && !details->empty()) {
+            throw chain_error(details->front().second.get<std::string>("message", response.body()));
+        }
+        throw chain_error(response.body());
+    }
+    return tree;
+}
+
+uint32_t parse_block_time(const std::string& text) {
+    std::tm time{};
+    std::istringstream stream(text);
+    stream >> std::get_time(&time, "%Y-%m-%dT%H:%M:%S");
+    if (stream.fail()) {
+        throw std::runtime_error("not a block time: " + text);
+    }
+    return static_cast<uint32_t>(timegm(&time));
+}
+
+chain_info chain_api::get_info() {
+    const auto tree = post("/v1/chain/get_info", "{}");
+    return {tree.get<std::string>("chain_id"),
+            tree.get<uint32_t>("head_block_num"),
+            tree.get<std::string>("head_block_id"),
+            parse_block_time(tree.get<std::string>("head_block_time"))};
+}
+
+boost::property_tree::ptree chain_api::get_table_rows(const std::string& code, const std::string& table, const std::string& scope,
+                                                      uint64_t lower_bound, uint32_t limit, bool& more) {
+    std::ostringstream body;
+    body << R"({"json":true,"code":")" << code << R"(","table":")" << table << R"(","scope":")" << scope
+         << R"(","lower_bound":")" << lower_bound << R"(","limit":)" << limit << "}";
+    auto tree = post("/v1/chain/get_table_rows", body.str());
+    more = tree.get<bool>("more", false);
+    return tree.get_child("rows", {});
+}
+
+std::string chain_api::push_transaction(const std::string& signature, const bytes& packed_trx) {
+    std::ostringstream body;
+    body << R"({"signatures":[")" << signature << R"("],"compression":"none","packed_context_free_data":"","packed_trx":")"
+         << to_hex(packed_trx) << R"("})";
+    return post("/v1/chain/push_transaction", body.str()).get<std::string>("transaction_id", "");
+}
+
+bytes chain_api::send_read_only_transaction(const bytes& packed_trx) {
+    std::ostringstream body;
+    body << R"({"transaction":{"signatures":[],"compression":"none","packed_context_free_data":"","packed_trx":")"
+         << to_hex(packed_trx) << R"("}})";
+    const auto tree = post("/v1/chain/send_read_only_transaction", body.str());
+    const auto except = tree.get_child_optional("processed.except");
+    if (except && !except->empty()) {
+        throw chain_error(except->get<std::string>("message", "read-only transaction failed"));
+    }
+    const auto traces = tree.get_child("processed.action_traces", {});
+    if (traces.empty()) {
+        throw chain_error("read-only transaction without action trace");
+    }
+    return from_hex(traces.front().second.get<std::string>("return_value_hex_data", ""));
+}
+
+transaction_header chain_api::make_header(const chain_info& info, uint32_t expire_seconds) {
+    // the prefix is the little-endian uint32 at bytes 8 to 11 of the block id
+    const bytes block_id = from_hex(info.head_block_id);
+    const uint32_t prefix = block_id[8] | block_id[9] << 8 | block_id[10] << 16 | static_cast<uint32_t>(block_id[11]) << 24;
+    return {info.head_block_time + expire_seconds, static_cast<uint16_t>(info.head_block_num & 0xffff), prefix};
+}
+
+} // namespace orng_oracle
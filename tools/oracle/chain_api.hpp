@@ -0,0 +1,84 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Minimal client of the nodeos HTTP API (chain plugin) over plain HTTP, one
+// keep-alive connection per object. Responses are read into property trees.
+
+#pragma once
+
+#include "eosio_tx.hpp"
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace orng_oracle {
+
+// The node answered with an error, e.g. an assertion of the contract
+class chain_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+struct chain_info {
+    std::string chain_id;
+    uint32_t    head_block_num;
+    std::string head_block_id;
+    uint32_t    head_block_time; // seconds since epoch
+};
+
+// seconds since epoch of a block time or time_point_sec, as the API prints them
+uint32_t parse_block_time(const std::string& text);
+
+class chain_api {
+public:
+    explicit chain_api(const std::string& url);
+    ~chain_api();
+
+    chain_info get_info();
+
+    // rows from lower_bound, at most limit of them; more is set if rows are left
+    boost::property_tree::ptree get_table_rows(const std::string& code, const std::string& table, const std::string& scope,
+                                               uint64_t lower_bound, uint32_t limit, bool& more);
+
+    // returns the transaction id
+    std::string push_transaction(const std::string& signature, const bytes& packed_trx);
+
+    // runs an unsigned transaction without committing it, returns the return
+    // value of its first action
+    bytes send_read_only_transaction(const bytes& packed_trx);
+
+    static transaction_header make_header(const chain_info& info, uint32_t expire_seconds);
+
+private:
+    boost::property_tree::ptree post(const std::string& target, const std::string& body);
+
+    struct connection;
+    std::string                 host;
+    std::string                 port;
+    std::unique_ptr<connection> conn;
+};
+
+} // namespace orng_oracle
@@ -0,0 +1,458 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#define OPENSSL_API_COMPAT 0x10100000L
+
+#include "eosio_tx.hpp"
+
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/ecdsa.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+#include <openssl/sha.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+namespace orng_oracle {
+
+namespace {
+
+const char base58_alphabet[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+using bn_ptr = std::unique_ptr<BIGNUM, decltype(&BN_free)>;
+using bn_ctx_ptr = std::unique_ptr<BN_CTX, decltype(&BN_CTX_free)>;
+using point_ptr = std::unique_ptr<EC_POINT, decltype(&EC_POINT_free)>;
+
+bn_ptr make_bn(BIGNUM* bn = BN_new()) {
+    if (!bn) {
+        throw std::bad_alloc();
+    }
+    return bn_ptr(bn, &BN_free);
+}
+
+bytes ripemd160(const bytes& data) {
+    bytes digest(20);
+    unsigned int size = 0;
+    if (EVP_Digest(data.data(), data.size(), digest.data(), &size, EVP_ripemd160(), nullptr) != 1) {
+        throw std::runtime_error("ripemd160 is not available in this OpenSSL");
+    }
+    return digest;
+}
+
+std::array<unsigned char, 32> sha256(const bytes& data) {
+    std::array<unsigned char, 32> digest;
+    SHA256(data.data(), data.size(), digest.data());
+    return digest;
+}
+
+// ripemd160 checksum of the data and the key type suffix, as in the K1 text forms
+bytes k1_checksum(const bytes& data, const std::string& suffix) {
+    bytes with_suffix = data;
+    with_suffix.insert(with_suffix.end(), suffix.begin(), suffix.end());
+    bytes digest = ripemd160(with_suffix);
+    digest.resize(4);
+    return digest;
+}
+
+bytes with_checksum(bytes data, const bytes& checksum) {
+    data.insert(data.end(), checksum.begin(), checksum.end());
+    return data;
+}
+
+const EC_GROUP* secp256k1() {
+    static const std::unique_ptr<EC_GROUP, decltype(&EC_GROUP_free)> group(
+        EC_GROUP_new_by_curve_name(NID_secp256k1), &EC_GROUP_free);
+    return group.get();
+}
+
+bytes compress_point(const EC_POINT* point, BN_CTX* ctx) {
+    bytes compressed(33);
+    if (EC_POINT_point2oct(secp256k1(), point, POINT_CONVERSION_COMPRESSED, compressed.data(), compressed.size(), ctx) != compressed.size()) {
+        throw std::runtime_error("cannot compress the public key");
+    }
+    return compressed;
+}
+
+// the chain only accepts signatures whose r and s do not need a sign byte in DER
+bool is_canonical(const std::array<unsigned char, 65>& c) {
+    return !(c[1] & 0x80) && !(c[1] == 0 && !(c[2] & 0x80)) &&
+           !(c[33] & 0x80) && !(c[33] == 0 && !(c[34] & 0x80));
+}
+
+} // namespace
+
+uint64_t string_to_name(const std::string& name) {
+    if (name.size() > 13) {
+        throw std::invalid_argument("name is longer than 13 characters: " + name);
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < name.size(); ++i) {
+        const char c = name[i];
+        uint64_t symbol = 0;
+        if (c >= 'a' && c <= 'z') symbol = c - 'a' + 6;
+        else if (c >= '1' && c <= '5') symbol = c - '1' + 1;
+        else if (c != '.') throw std::invalid_argument("invalid character in name: " + name);
+
+        if (i < 12) {
+            value |= (symbol & 0x1f) << (64 - 5 * (i + 1));
+        } else {
+            if (symbol > 0x0f) throw std::invalid_argument("invalid 13th character in name: " + name);
+            value |= symbol;
+        }
+    }
+    return value;
+}
+
+std::string name_to_string(uint64_t value) {
+    static const char symbols[] = ".12345abcdefghijklmnopqrstuvwxyz";
+    std::string name(13, '.');
+    name[12] = symbols[value & 0x0f];
+    value >>= 4;
+    for (int i = 11; i >= 0; --i) {
+        name[i] = symbols[value & 0x1f];
+        value >>= 5;
+    }
+    name.erase(name.find_last_not_of('.') + 1);
+    return name;
+}
+
+std::string to_hex(const unsigned char* data, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(size * 2, '0');
+    for (size_t i = 0; i < size; ++i) {
+        hex[i * 2] = digits[data[i] >> 4];
+        hex[i * 2 + 1] = digits[data[i] & 0x0f];
+    }
+    return hex;
+}
+
+bytes from_hex(const std::string& hex) {
+    if (hex.size() % 2) {
+        throw std::invalid_argument("odd length hex string");
+    }
+    auto nibble = [](char c) -> unsigned {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        throw std::invalid_argument("invalid hex character");
+    };
+    bytes data(hex.size() / 2);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>(nibble(hex[i * 2]) << 4 | nibble(hex[i * 2 + 1]));
+    }
+    return data;
+}
+
+std::string base58_encode(const bytes& data) {
+    // base 58 digits, least significant first
+    std::vector<unsigned char> digits;
+    for (unsigned char byte : data) {
+        unsigned carry = byte;
+        for (auto& digit : digits) {
+            carry += static_cast<unsigned>(digit) << 8;
+            digit = carry % 58;
+            carry /= 58;
+        }
+        while (carry) {
+            digits.push_back(carry % 58);
+            carry /= 58;
+        }
+    }
+    std::string text;
+    for (size_t i = 0; i < data.size() && data[i] == 0; ++i) {
+        text += '1';
+    }
+    for (auto it = digits.rbegin(); it != digits.rend(); ++it) {
+        text += base58_alphabet[*it];
+    }
+    return text;
+}
+
+bytes base58_decode(const std::string& text) {
+    // bytes, least significant first
+    bytes data;
+    for (char c : text) {
+        const char* pos = std::find(base58_alphabet, base58_alphabet + 58, c);
+        if (pos == base58_alphabet + 58) {
+            throw std::invalid_argument("invalid base58 character");
+        }
+        unsigned carry = static_cast<unsigned>(pos - base58_alphabet);
+        for (auto& byte : data) {
+            carry += static_cast<unsigned>(byte) * 58;
+            byte = carry & 0xff;
+            carry >>= 8;
+        }
+        while (carry) {
+            data.push_back(carry & 0xff);
+            carry >>= 8;
+        }
+    }
+    for (size_t i = 0; i < text.size() && text[i] == '1'; ++i) {
+        data.push_back(0);
+    }
+    std::reverse(data.begin(), data.end());
+    return data;
+}
+
+packer& packer::u8(uint8_t value) {
+    buffer.push_back(value);
+    return *this;
+}
+
+packer& packer::u16(uint16_t value) {
+    for (size_t i = 0; i < sizeof(value); ++i) buffer.push_back(static_cast<unsigned char>(value >> (8 * i)));
+    return *this;
+}
+
+packer& packer::u32(uint32_t value) {
+    for (size_t i = 0; i < sizeof(value); ++i) buffer.push_back(static_cast<unsigned char>(value >> (8 * i)));
+    return *this;
+}
+
+packer& packer::u64(uint64_t value) {
+    for (size_t i = 0; i < sizeof(value); ++i) buffer.push_back(static_cast<unsigned char>(value >> (8 * i)));
+    return *this;
+}
+
+packer& packer::varuint32(uint32_t value) {
+    do {
+        unsigned char byte = value & 0x7f;
+        value >>= 7;
+        buffer.push_back(byte | (value ? 0x80 : 0));
+    } while (value);
+    return *this;
+}
+
+packer& packer::string(const std::string& value) {
+    varuint32(static_cast<uint32_t>(value.size()));
+    buffer.insert(buffer.end(), value.begin(), value.end());
+    return *this;
+}
+
+packer& packer::raw(const bytes& value) {
+    buffer.insert(buffer.end(), value.begin(), value.end());
+    return *this;
+}
+
+packer& packer::blob(const bytes& value) {
+    varuint32(static_cast<uint32_t>(value.size()));
+    return raw(value);
+}
+
+uint8_t unpacker::u8() {
+    if (pos >= buffer.size()) {
+        throw std::runtime_error("unexpected end of data");
+    }
+    return buffer[pos++];
+}
+
+uint64_t unpacker::u64() {
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(value); ++i) value |= static_cast<uint64_t>(u8()) << (8 * i);
+    return value;
+}
+
+uint32_t unpacker::varuint32() {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        const uint8_t byte = u8();
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("varuint32 is too long");
+}
+
+bytes pack_transaction(const transaction_header& header, const std::vector<action>& actions) {
+    packer trx;
+    trx.u32(header.expiration)
+       .u16(header.ref_block_num)
+       .u32(header.ref_block_prefix)
+       .varuint32(0)  // max_net_usage_words
+       .u8(0)         // max_cpu_usage_ms
+       .varuint32(0)  // delay_sec
+       .varuint32(0); // context_free_actions
+    trx.varuint32(static_cast<uint32_t>(actions.size()));
+    for (const auto& act : actions) {
+        trx.name(act.account).name(act.name);
+        trx.varuint32(static_cast<uint32_t>(act.authorization.size()));
+        for (const auto& level : act.authorization) {
+            trx.name(level.actor).name(level.permission);
+        }
+        trx.blob(act.data);
+    }
+    trx.varuint32(0); // transaction_extensions
+    return trx.data();
+}
+
+struct k1_private_key::impl {
+    EC_KEY* ec_key = nullptr;
+    bytes   public_key; // compressed
+};
+
+k1_private_key::k1_private_key(const std::string& text) : key(new impl) {
+    bytes secret;
+    const std::string pvt_prefix = "PVT_K1_";
+    if (text.rfind(pvt_prefix, 0) == 0) {
+        const bytes data = base58_decode(text.substr(pvt_prefix.size()));
+        if (data.size() != 36) throw std::invalid_argument("invalid PVT_K1_ private key");
+        secret.assign(data.begin(), data.begin() + 32);
+        if (k1_checksum(secret, "K1") != bytes(data.begin() + 32, data.end())) {
+            throw std::invalid_argument("invalid PVT_K1_ private key checksum");
+        }
+    } else {
+        // WIF: 0x80, the key and the first 4 bytes of its double sha256
+        const bytes data = base58_decode(text);
+        if (data.size() != 37 || data[0] != 0x80) throw std::invalid_argument("invalid WIF private key");
+        const auto first = sha256(bytes(data.begin(), data.begin() + 33));
+        const auto checksum = sha256(bytes(first.begin(), first.end()));
+        if (!std::equal(checksum.begin(), checksum.begin() + 4, data.begin() + 33)) {
+            throw std::invalid_argument("invalid WIF private key checksum");
+        }
+        secret.assign(data.begin() + 1, data.begin() + 33);
+    }
+
+    bn_ctx_ptr ctx(BN_CTX_new(), &BN_CTX_free);
+    auto priv = make_bn(BN_bin2bn(secret.data(), static_cast<int>(secret.size()), nullptr));
+    point_ptr pub(EC_POINT_new(secp256k1()), &EC_POINT_free);
+    key->ec_key = EC_KEY_new_by_curve_name(NID_secp256k1);
+    if (!key->ec_key || !pub ||
+        EC_POINT_mul(secp256k1(), pub.get(), priv.get(), nullptr, nullptr, ctx.get()) != 1 ||
+        EC_KEY_set_private_key(key->ec_key, priv.get()) != 1 ||
+        EC_KEY_set_public_key(key->ec_key, pub.get()) != 1) {
+        EC_KEY_free(key->ec_key);
+        delete key;
+        throw std::runtime_error("cannot load the K1 private key");
+    }
+    key->public_key = compress_point(pub.get(), ctx.get());
+}
+
+k1_private_key::~k1_private_key() {
+    EC_KEY_free(key->ec_key);
+    delete key;
+}
+
+std::string k1_private_key::public_key() const {
+    return public_key_to_string(key->public_key);
+}
+
+std::array<unsigned char, 65> k1_private_key::sign_digest(const std::array<unsigned char, 32>& digest) const {
+    bn_ctx_ptr ctx(BN_CTX_new(), &BN_CTX_free);
+    auto order = make_bn();
+    auto half_order = make_bn();
+    EC_GROUP_get_order(secp256k1(), order.get(), ctx.get());
+    BN_rshift1(half_order.get(), order.get());
+
+    // the nonce is random, signing again gives another candidate until one is canonical
+    for (;;) {
+        std::unique_ptr<ECDSA_SIG, decltype(&ECDSA_SIG_free)> sig(
+            ECDSA_do_sign(digest.data(), static_cast<int>(digest.size()), key->ec_key), &ECDSA_SIG_free);
+        if (!sig) {
+            throw std::runtime_error("ECDSA signing failed");
+        }
+        const BIGNUM* r = ECDSA_SIG_get0_r(sig.get());
+        auto s = make_bn(BN_dup(ECDSA_SIG_get0_s(sig.get())));
+        if (BN_cmp(s.get(), half_order.get()) > 0) {
+            BN_sub(s.get(), order.get(), s.get());
+        }
+
+        std::array<unsigned char, 65> signature{};
+        BN_bn2binpad(r, signature.data() + 1, 32);
+        BN_bn2binpad(s.get(), signature.data() + 33, 32);
+        if (!is_canonical(signature)) {
+            continue;
+        }
+        for (unsigned char recovery_id = 0; recovery_id < 4; ++recovery_id) {
+            signature[0] = 27 + 4 + recovery_id; // compressed public key
+            try {
+                if (recover_public_key(digest, signature) == key->public_key) {
+                    return signature;
+                }
+            } catch (const std::runtime_error&) {
+                // no curve point for this recovery id
+            }
+        }
+    }
+}
+
+std::string k1_private_key::sign_transaction(const std::string& chain_id, const bytes& packed_trx) const {
+    bytes signed_data = from_hex(chain_id);
+    signed_data.insert(signed_data.end(), packed_trx.begin(), packed_trx.end());
+    signed_data.insert(signed_data.end(), 32, 0); // no context free data
+    return signature_to_string(sign_digest(sha256(signed_data)));
+}
+
+std::string signature_to_string(const std::array<unsigned char, 65>& signature) {
+    const bytes data(signature.begin(), signature.end());
+    return "SIG_K1_" + base58_encode(with_checksum(data, k1_checksum(data, "K1")));
+}
+
+bytes recover_public_key(const std::array<unsigned char, 32>& digest, const std::array<unsigned char, 65>& signature) {
+    const int recovery_id = signature[0] - 27 - 4;
+    if (recovery_id < 0 || recovery_id > 3) {
+        throw std::invalid_argument("not a compressed key recoverable signature");
+    }
+
+    const EC_GROUP* group = secp256k1();
+    bn_ctx_ptr ctx(BN_CTX_new(), &BN_CTX_free);
+    auto order = make_bn();
+    EC_GROUP_get_order(group, order.get(), ctx.get());
+    auto r = make_bn(BN_bin2bn(signature.data() + 1, 32, nullptr));
+    auto s = make_bn(BN_bin2bn(signature.data() + 33, 32, nullptr));
+    auto e = make_bn(BN_bin2bn(digest.data(), 32, nullptr));
+
+    // R has x = r + (recovery_id / 2) * order and the y parity of recovery_id
+    auto x = make_bn(BN_dup(r.get()));
+    if (recovery_id & 2) {
+        BN_add(x.get(), x.get(), order.get());
+    }
+    point_ptr big_r(EC_POINT_new(group), &EC_POINT_free);
+    if (EC_POINT_set_compressed_coordinates(group, big_r.get(), x.get(), recovery_id & 1, ctx.get()) != 1) {
+        throw std::runtime_error("no curve point for the recovery id");
+    }
+
+    // Q = r^-1 (s R - e G)
+    auto r_inv = make_bn(BN_mod_inverse(nullptr, r.get(), order.get(), ctx.get()));
+    auto u1 = make_bn();
+    auto u2 = make_bn();
+    BN_mod_mul(u1.get(), e.get(), r_inv.get(), order.get(), ctx.get());
+    BN_sub(u1.get(), order.get(), u1.get());
+    BN_mod(u1.get(), u1.get(), order.get(), ctx.get());
+    BN_mod_mul(u2.get(), s.get(), r_inv.get(), order.get(), ctx.get());
+    point_ptr q(EC_POINT_new(group), &EC_POINT_free);
+    if (EC_POINT_mul(group, q.get(), u1.get(), big_r.get(), u2.get(), ctx.get()) != 1) {
+        throw std::runtime_error("cannot recover the public key");
+    }
+    return compress_point(q.get(), ctx.get());
+}
+
+std::string public_key_to_string(const bytes& compressed_key) {
+    bytes checksum = ripemd160(compressed_key);
+    checksum.resize(4);
+    return "EOS" + base58_encode(with_checksum(compressed_key, checksum));
+}
+
+} // namespace orng_oracle
@@ -0,0 +1,134 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// The parts of an EOSIO transaction the oracle needs, built with OpenSSL
+// only: account names, the binary serialization of actions and
+// transactions, and K1 keys and signatures in their EOS text forms.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace orng_oracle {
+
+using bytes = std::vector<unsigned char>;
+
+uint64_t string_to_name(const std::string& name);
+std::string name_to_string(uint64_t value);
+
+std::string to_hex(const unsigned char* data, size_t size);
+inline std::string to_hex(const bytes& data) { return to_hex(data.data(), data.size()); }
+bytes from_hex(const std::string& hex);
+
+std::string base58_encode(const bytes& data);
+bytes base58_decode(const std::string& text);
+
+// Appends values in the EOSIO binary format
+class packer {
+public:
+    packer& u8(uint8_t value);
+    packer& u16(uint16_t value);
+    packer& u32(uint32_t value);
+    packer& u64(uint64_t value);
+    packer& varuint32(uint32_t value);
+    packer& name(const std::string& value) { return u64(string_to_name(value)); }
+    packer& string(const std::string& value);
+    packer& raw(const bytes& value);
+    packer& blob(const bytes& value); // varuint32 size, then the bytes
+
+    const bytes& data() const { return buffer; }
+
+private:
+    bytes buffer;
+};
+
+// Reads values in the EOSIO binary format, throwing past the end of the data
+class unpacker {
+public:
+    explicit unpacker(const bytes& data) : buffer(data) {}
+
+    uint8_t u8();
+    uint64_t u64();
+    uint32_t varuint32();
+    std::string name() { return name_to_string(u64()); }
+
+    bool done() const { return pos == buffer.size(); }
+
+private:
+    const bytes& buffer;
+    size_t       pos = 0;
+};
+
+struct permission_level {
+    std::string actor;
+    std::string permission;
+};
+
+struct action {
+    std::string                   account;
+    std::string                   name;
+    std::vector<permission_level> authorization;
+    bytes                         data;
+};
+
+// Header fields taken from the head block, see chain_api::get_info
+struct transaction_header {
+    uint32_t expiration;       // seconds since epoch
+    uint16_t ref_block_num;
+    uint32_t ref_block_prefix;
+};
+
+bytes pack_transaction(const transaction_header& header, const std::vector<action>& actions);
+
+// A secp256k1 private key, from the WIF or PVT_K1_ text forms
+class k1_private_key {
+public:
+    explicit k1_private_key(const std::string& text);
+    k1_private_key(const k1_private_key&) = delete;
+    k1_private_key& operator=(const k1_private_key&) = delete;
+    ~k1_private_key();
+
+    // EOS... legacy text form of the public key
+    std::string public_key() const;
+
+    // canonical, recoverable SIG_K1_... signature of the transaction for the chain
+    std::string sign_transaction(const std::string& chain_id, const bytes& packed_trx) const;
+
+    // canonical, recoverable signature of a sha256 digest, recovery header byte first
+    std::array<unsigned char, 65> sign_digest(const std::array<unsigned char, 32>& digest) const;
+
+private:
+    struct impl;
+    impl* key;
+};
+
+std::string signature_to_string(const std::array<unsigned char, 65>& signature);
+
+// the compressed public key recovered from a signature made by sign_digest
+bytes recover_public_key(const std::array<unsigned char, 32>& digest, const std::array<unsigned char, 65>& signature);
+
+std::string public_key_to_string(const bytes& compressed_key);
+
+} // namespace orng_oracle
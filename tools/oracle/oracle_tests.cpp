@@ -0,0 +1,124 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Offline checks of the transaction encoding and signing of orng_oracled,
+// against the well known development key of the local chains.
+
+#include "chain_api.hpp"
+#include "eosio_tx.hpp"
+
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace orng_oracle;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+const char* dev_private_key = "5KQwrPbwdL6PhXujxW37FSSQZ1JiwsST4cqQzDeyXtP79zkvFD3";
+const char* dev_public_key = "EOS6MRyAjQq8ud7hVNYcfnVPJqcVpscN5So8BhtHuGYqET5GDW5CV";
+
+// the order of secp256k1, a canonical signature has s <= n / 2
+const char* half_order = "7fffffffffffffffffffffffffffffff5d576e7357a4501ddfe92f46681b20a0";
+
+void test_names() {
+    check(string_to_name("eosio") == 6138663577826885632ull, "eosio name");
+    check(string_to_name("oracle.wax") == 0xa5cc88a81c374000ull, "oracle.wax name");
+    check(string_to_name("") == 0, "empty name");
+    check(name_to_string(string_to_name("oracle.wax")) == "oracle.wax", "oracle.wax name round trip");
+    check(name_to_string(string_to_name("lane.paid...1")) == "lane.paid...1", "shard scope round trip");
+    check(name_to_string(0).empty(), "empty name round trip");
+}
+
+void test_packing() {
+    packer data;
+    data.varuint32(2).u64(1).string("ab").varuint32(300);
+    check(to_hex(data.data()) == "020100000000000000026162ac02", "setrandbatch packing");
+    check(base58_decode(base58_encode(from_hex("0000ff01"))) == from_hex("0000ff01"), "base58 round trip");
+
+    unpacker read(data.data());
+    check(read.varuint32() == 2 && read.u64() == 1, "setrandbatch unpacking");
+    check(read.varuint32() == 2 && read.u8() == 'a' && read.u8() == 'b' && read.varuint32() == 300 && read.done(),
+          "string and varuint32 unpacking");
+}
+
+void test_block_time() {
+    check(parse_block_time("1970-01-01T00:00:00") == 0, "epoch block time");
+    check(parse_block_time("2024-02-29T12:34:56.500") == 1709210096, "block time with milliseconds");
+    check(parse_block_time("2024-02-29T12:34:56") == 1709210096, "time_point_sec");
+}
+
+void test_keys() {
+    const k1_private_key key(dev_private_key);
+    check(key.public_key() == dev_public_key, "public key of the WIF key");
+
+    // the same key in the PVT_K1_ form: the secret, then its ripemd160(secret || "K1") checksum
+    const bytes wif = base58_decode(dev_private_key);
+    bytes secret(wif.begin() + 1, wif.begin() + 33);
+    bytes with_suffix = secret;
+    with_suffix.push_back('K');
+    with_suffix.push_back('1');
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int size = 0;
+    EVP_Digest(with_suffix.data(), with_suffix.size(), digest, &size, EVP_ripemd160(), nullptr);
+    secret.insert(secret.end(), digest, digest + 4);
+    check(k1_private_key("PVT_K1_" + base58_encode(secret)).public_key() == dev_public_key, "public key of the PVT_K1_ key");
+}
+
+void test_signatures() {
+    const k1_private_key key(dev_private_key);
+    for (int i = 0; i < 32; ++i) {
+        std::array<unsigned char, 32> digest;
+        const unsigned char message = static_cast<unsigned char>(i);
+        SHA256(&message, 1, digest.data());
+
+        const auto signature = key.sign_digest(digest);
+        check(public_key_to_string(recover_public_key(digest, signature)) == dev_public_key, "recovered public key");
+        check(to_hex(signature.data() + 33, 32) <= half_order, "canonical signature");
+        check(signature_to_string(signature).rfind("SIG_K1_", 0) == 0, "signature format");
+    }
+}
+
+} // namespace
+
+int main() {
+    test_names();
+    test_packing();
+    test_block_time();
+    test_keys();
+    test_signatures();
+    if (failures == 0) {
+        std::cout << "all checks passed" << std::endl;
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,597 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Reference oracle: fulfills the jobs of the orng contract from a node's HTTP
+// API. Polling, signing and submission are separate stages joined by bounded
+// queues, so a slow node or a slow signer only holds back its own stage:
+//
+//   poller     pages through getjobfeed, queues the new jobs
+//   signers    a pool of threads signing the signing values with the RSA keys
+//   submitter  packs the signatures into setrandbatch transactions, billed to
+//              the bandwidth payer of the jobs when they have one
+//   streamer   reads streams.a and sets the due values of the streams with
+//              setstreamrnd, one transaction per value
+//
+//   orng_oracled --tx-key KEY --rsa-key ID=PEM [--rsa-key ID=PEM...] [options]
+//
+//   --url URL           node HTTP API, http://127.0.0.1:8888 by default
+//   --contract NAME     orng.wax by default
+//   --account NAME      oracle.wax by default, signing with its --permission (active)
+//   --tx-key KEY        WIF or PVT_K1_ private key of the account, or $ORNG_ORACLE_TX_KEY
+//   --rsa-key ID=PEM    private RSA key of the public key id ID, once per key
+//   --threads N         signer threads, one per core by default
+//   --batch N           results per setrandbatch, 20 by default
+//   --poll-ms N         pause between polls, 500 by default
+//   --retry-s N         seconds before a job still pending is signed again, 30 by default
+//   --report-s N        seconds between throughput reports, 10 by default
+//   --exit-after N      exit once N jobs are fulfilled, never by default
+//
+// getjobfeed is read with read-only transactions, which need a node with
+// the read-only transaction API. Its pages merge the lanes and shards of the
+// jobs in job id order. Each job names the key signing it. A job whose key has
+// no --rsa-key is left to another oracle, so the keys active at once
+// (setkeyslots) can be spread over several daemons.
+//
+// The jobs of a dapp whose bandwidth payer accepted to pay are submitted in
+// transactions of their own, starting with boost.wax::noop authorized by
+// payer@paybw so the payer is billed, as set up in "Register bandwidth payer"
+// of the README. The oracle account must then sign with the permission paybw
+// is delegated to, e.g. --permission rngops.
+//
+// setrandbatch takes the jobs of every shard, so setrandshard is left to
+// deployments running one worker per shard.
+
+#include "chain_api.hpp"
+#include "eosio_tx.hpp"
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <initializer_list>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace orng_oracle;
+using std::chrono::steady_clock;
+
+namespace {
+
+struct options {
+    std::string                        url = "http://127.0.0.1:8888";
+    std::string                        contract = "orng.wax";
+    std::string                        account = "oracle.wax";
+    std::string                        permission = "active";
+    std::string                        tx_key;
+    std::map<uint64_t, std::string>    rsa_keys;
+    unsigned                           threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t                             batch = 20;
+    uint32_t                           poll_ms = 500;
+    uint32_t                           retry_s = 30;
+    uint32_t                           report_s = 10;
+    uint64_t                           exit_after = 0;
+};
+
+constexpr uint64_t feed_page_size = 1000;
+
+struct job {
+    uint64_t    id;
+    uint64_t    signing_value;
+    uint64_t    key_id;
+    bool        derived; // signing value derived by the contract, signed along with the id
+    std::string payer;   // bandwidth payer of the dapp, empty if none
+};
+
+struct result {
+    uint64_t    job_id;
+    std::string random_value;
+    std::string payer;
+};
+
+// Bounded queue between two stages, pushing blocks while it is full
+template <typename T>
+class stage_queue {
+public:
+    explicit stage_queue(size_t capacity) : capacity(capacity) {}
+
+    bool push(T item) {
+        std::unique_lock lock(mutex);
+        not_full.wait(lock, [&] { return items.size() < capacity || closed; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+        return true;
+    }
+
+    // waits up to timeout for an item, nothing once closed and drained
+    std::optional<T> pop(std::chrono::milliseconds timeout) {
+        std::unique_lock lock(mutex);
+        not_empty.wait_for(lock, timeout, [&] { return !items.empty() || closed; });
+        if (items.empty()) {
+            return std::nullopt;
+        }
+        T item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return item;
+    }
+
+    void close() {
+        std::lock_guard lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+    bool is_closed() {
+        std::lock_guard lock(mutex);
+        return closed;
+    }
+
+private:
+    const size_t            capacity;
+    std::deque<T>           items;
+    bool                    closed = false;
+    std::mutex              mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+};
+
+struct counters {
+    std::atomic<uint64_t> signed_jobs{0};
+    std::atomic<uint64_t> fulfilled{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> streamed{0};
+};
+
+std::atomic<bool> stopping{false};
+
+void on_signal(int) {
+    stopping = true;
+}
+
+std::mutex log_mutex;
+
+template <typename... Args>
+void log(const Args&... args) {
+    std::lock_guard lock(log_mutex);
+    ((std::cerr << args), ...) << std::endl;
+}
+
+using pkey_ptr = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
+
+// signs the little-endian uint64 values, as verify_rsa_sha256_sig checks them
+std::string sign_values(EVP_PKEY* key, EVP_MD_CTX* md_ctx, std::initializer_list<uint64_t> values) {
+    std::vector<unsigned char> message;
+    for (const uint64_t value : values) {
+        for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+            message.push_back(static_cast<unsigned char>(value >> (8 * i)));
+        }
+    }
+    std::vector<unsigned char> signature(EVP_PKEY_get_size(key));
+    size_t size = signature.size();
+    EVP_MD_CTX_reset(md_ctx);
+    if (EVP_DigestSignInit(md_ctx, nullptr, EVP_sha256(), nullptr, key) != 1 ||
+        EVP_DigestSign(md_ctx, signature.data(), &size, message.data(), message.size()) != 1) {
+        throw std::runtime_error("RSA signing failed");
+    }
+    return to_hex(signature.data(), size);
+}
+
+std::string sign_job(EVP_PKEY* key, EVP_MD_CTX* md_ctx, const job& next) {
+    // the signing value, followed by the job id for derived signing values
+    return next.derived ? sign_values(key, md_ctx, {next.signing_value, next.id})
+                        : sign_values(key, md_ctx, {next.signing_value});
+}
+
+// Loads the PEM with its CRT parameters and signs once, so the Montgomery
+// contexts of p and q are cached in the key before the signers share it
+pkey_ptr load_rsa_key(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (!file) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    pkey_ptr key(PEM_read_PrivateKey(file, nullptr, nullptr, nullptr), &EVP_PKEY_free);
+    std::fclose(file);
+    if (!key || EVP_PKEY_base_id(key.get()) != EVP_PKEY_RSA) {
+        throw std::runtime_error("not an RSA private key: " + path);
+    }
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> md_ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+    sign_values(key.get(), md_ctx.get(), {0});
+    return key;
+}
+
+struct feed_page {
+    std::vector<job> jobs;
+    uint64_t         cursor;
+};
+
+// A page of getjobfeed from cursor, see orng::job_feed for its layout
+feed_page get_job_feed(chain_api& chain, const options& opts, const transaction_header& header, uint64_t cursor) {
+    packer data;
+    data.u64(cursor).u64(feed_page_size);
+    const action getjobfeed{opts.contract, "getjobfeed", {}, data.data()};
+    const bytes value = chain.send_read_only_transaction(pack_transaction(header, {getjobfeed}));
+
+    unpacker read(value);
+    feed_page page;
+    page.jobs.resize(read.varuint32());
+    for (auto& next : page.jobs) {
+        next.id = read.u64();
+        next.signing_value = read.u64();
+        next.key_id = read.u64();
+        read.name(); // caller
+        next.payer = read.name();
+        next.derived = read.u8() != 0;
+    }
+    page.cursor = read.u64();
+    return page;
+}
+
+void poll_jobs(const options& opts, stage_queue<job>& jobs, const std::set<uint64_t>& loaded_keys) {
+    chain_api chain(opts.url);
+    std::map<uint64_t, steady_clock::time_point> dispatched;
+    std::set<uint64_t> reported_keys;
+    uint64_t cursor = 0;
+    steady_clock::time_point last_sweep;
+
+    while (!stopping) {
+        try {
+            // a sweep reads the feed from the first job, to sign again the jobs
+            // still pending after --retry-s and forget the fulfilled ones, the
+            // polls in between only read the jobs requested since the last one
+            const auto now = steady_clock::now();
+            const bool sweep = now - last_sweep >= std::chrono::seconds(opts.retry_s);
+            const auto header = chain_api::make_header(chain.get_info(), 60);
+            std::set<uint64_t> pending;
+            uint64_t from = sweep ? 0 : cursor;
+            while (!stopping) {
+                const auto page = get_job_feed(chain, opts, header, from);
+                for (const auto& next : page.jobs) {
+                    pending.insert(next.id);
+
+                    auto sent = dispatched.find(next.id);
+                    if (sent != dispatched.end() && now - sent->second < std::chrono::seconds(opts.retry_s)) {
+                        continue;
+                    }
+                    if (!loaded_keys.count(next.key_id)) {
+                        if (reported_keys.insert(next.key_id).second) {
+                            log("no --rsa-key for key ", next.key_id, ", its jobs are skipped");
+                        }
+                        continue;
+                    }
+                    if (!jobs.push(next)) {
+                        return;
+                    }
+                    dispatched[next.id] = now;
+                }
+                from = page.cursor;
+                if (page.jobs.size() < feed_page_size) {
+                    break;
+                }
+            }
+            cursor = from;
+
+            if (sweep) {
+                // forget the fulfilled jobs
+                for (auto it = dispatched.begin(); it != dispatched.end();) {
+                    it = pending.count(it->first) ? std::next(it) : dispatched.erase(it);
+                }
+                last_sweep = now;
+            }
+        } catch (const std::exception& e) {
+            log("poll failed: ", e.what());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(opts.poll_ms));
+    }
+}
+
+void sign_jobs(const std::map<uint64_t, pkey_ptr>& rsa_keys, stage_queue<job>& jobs, stage_queue<result>& results, counters& counts) {
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> md_ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+    while (true) {
+        auto next = jobs.pop(std::chrono::milliseconds(100));
+        if (!next) {
+            if (jobs.is_closed()) {
+                return;
+            }
+            continue;
+        }
+        try {
+            std::string random_value = sign_job(rsa_keys.at(next->key_id).get(), md_ctx.get(), *next);
+            ++counts.signed_jobs;
+            if (!results.push({next->id, std::move(random_value), next->payer})) {
+                return;
+            }
+        } catch (const std::exception& e) {
+            log("job ", next->id, ": ", e.what());
+            ++counts.failed;
+        }
+    }
+}
+
+class submitter {
+public:
+    submitter(const options& opts, counters& counts)
+        : opts(opts), chain(opts.url), tx_key(opts.tx_key), counts(counts) {}
+
+    void run(stage_queue<result>& results) {
+        // a transaction bills a single payer, so the batches are kept by payer
+        std::map<std::string, std::vector<result>> batches;
+        while (true) {
+            auto next = results.pop(std::chrono::milliseconds(100));
+            if (next) {
+                auto& batch = batches[next->payer];
+                batch.push_back(std::move(*next));
+                if (batch.size() >= opts.batch) {
+                    submit(batch);
+                    batch.clear();
+                }
+            } else {
+                // partial batches leave as soon as the queue runs dry
+                for (auto& [payer, batch] : batches) {
+                    if (!batch.empty()) {
+                        submit(batch);
+                        batch.clear();
+                    }
+                }
+            }
+            if (!next && results.is_closed()) {
+                return;
+            }
+            if (opts.exit_after && counts.fulfilled >= opts.exit_after) {
+                stopping = true;
+            }
+        }
+    }
+
+private:
+    void submit(std::vector<result>& batch) {
+        // consecutive jobs share the signing key lookup of the contract
+        std::sort(batch.begin(), batch.end(), [](const auto& a, const auto& b) { return a.job_id < b.job_id; });
+        try {
+            push(batch);
+            counts.fulfilled += batch.size();
+        } catch (const chain_error& e) {
+            if (batch.size() == 1) {
+                log("job ", batch[0].job_id, ": ", e.what());
+                ++counts.failed;
+                return;
+            }
+            // one bad job fails the whole batch, the others go on alone
+            for (const auto& single : batch) {
+                std::vector<result> one{single};
+                submit(one);
+            }
+        } catch (const std::exception& e) {
+            log("submit failed, the jobs are polled again: ", e.what());
+            counts.failed += batch.size();
+        }
+    }
+
+    void push(const std::vector<result>& batch) {
+        const auto now = steady_clock::now();
+        if (!info || now - info_time > std::chrono::seconds(1)) {
+            info = chain.get_info();
+            info_time = now;
+        }
+
+        packer data;
+        data.varuint32(static_cast<uint32_t>(batch.size()));
+        for (const auto& item : batch) {
+            data.u64(item.job_id).string(item.random_value);
+        }
+        std::vector<action> actions;
+        if (!batch.front().payer.empty()) {
+            // the first authorizer pays the CPU and NET of the transaction
+            actions.push_back({"boost.wax", "noop", {{batch.front().payer, "paybw"}}, {}});
+        }
+        actions.push_back({opts.contract, "setrandbatch", {{opts.account, opts.permission}}, data.data()});
+        const bytes packed_trx = pack_transaction(chain_api::make_header(*info, 60), actions);
+        chain.push_transaction(tx_key.sign_transaction(info->chain_id, packed_trx), packed_trx);
+    }
+
+    const options&                    opts;
+    chain_api                         chain;
+    k1_private_key                    tx_key;
+    counters&                         counts;
+    std::optional<chain_info>         info;
+    steady_clock::time_point          info_time;
+};
+
+// Sets the due values of the streams, each signed as its id, sequence number
+// and seed. A value is due once the head block time reaches next_due.
+void serve_streams(const options& opts, const std::map<uint64_t, pkey_ptr>& rsa_keys, counters& counts) {
+    chain_api chain(opts.url);
+    k1_private_key tx_key(opts.tx_key);
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> md_ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+
+    while (!stopping) {
+        try {
+            const auto info = chain.get_info();
+            const auto header = chain_api::make_header(info, 60);
+            uint64_t from = 0;
+            bool more = true;
+            while (more && !stopping) {
+                const auto rows = chain.get_table_rows(opts.contract, "streams.a", opts.contract, from, 100, more);
+                for (const auto& item : rows) {
+                    const auto& row = item.second;
+                    const auto id = row.get<uint64_t>("id");
+                    from = id + 1;
+                    const auto key = rsa_keys.find(row.get<uint64_t>("key_id"));
+                    if (key == rsa_keys.end() || parse_block_time(row.get<std::string>("next_due")) > info.head_block_time) {
+                        continue;
+                    }
+
+                    const auto seq = row.get<uint64_t>("next_seq");
+                    packer data;
+                    data.u64(id).u64(seq).string(sign_values(key->second.get(), md_ctx.get(), {id, seq, row.get<uint64_t>("seed")}));
+                    const action setstreamrnd{opts.contract, "setstreamrnd", {{opts.account, opts.permission}}, data.data()};
+                    const bytes packed_trx = pack_transaction(header, {setstreamrnd});
+                    try {
+                        chain.push_transaction(tx_key.sign_transaction(info.chain_id, packed_trx), packed_trx);
+                        ++counts.streamed;
+                    } catch (const chain_error& e) {
+                        log("stream ", id, ": ", e.what());
+                    }
+                }
+            }
+        } catch (const std::exception& e) {
+            log("stream poll failed: ", e.what());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(opts.poll_ms));
+    }
+}
+
+int usage(const std::string& error = {}) {
+    if (!error.empty()) {
+        std::cerr << error << "\n";
+    }
+    std::cerr << "usage: orng_oracled --tx-key KEY --rsa-key ID=PEM [--rsa-key ID=PEM...] [--url URL] [--contract NAME]\n"
+                 "                    [--account NAME] [--permission NAME] [--threads N] [--batch N]\n"
+                 "                    [--poll-ms N] [--retry-s N] [--report-s N] [--exit-after N]\n";
+    return 2;
+}
+
+bool parse_options(int argc, char** argv, options& opts) {
+    auto number = [](const std::string& text) { return std::stoull(text); };
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--url") opts.url = value;
+        else if (arg == "--contract") opts.contract = value;
+        else if (arg == "--account") opts.account = value;
+        else if (arg == "--permission") opts.permission = value;
+        else if (arg == "--tx-key") opts.tx_key = value;
+        else if (arg == "--threads") opts.threads = static_cast<unsigned>(std::max(1ull, number(value)));
+        else if (arg == "--batch") opts.batch = std::max(1ull, number(value));
+        else if (arg == "--poll-ms") opts.poll_ms = static_cast<uint32_t>(number(value));
+        else if (arg == "--retry-s") opts.retry_s = static_cast<uint32_t>(number(value));
+        else if (arg == "--report-s") opts.report_s = static_cast<uint32_t>(std::max(1ull, number(value)));
+        else if (arg == "--exit-after") opts.exit_after = number(value);
+        else if (arg == "--rsa-key") {
+            const auto equal = value.find('=');
+            if (equal == std::string::npos) {
+                return false;
+            }
+            opts.rsa_keys[number(value.substr(0, equal))] = value.substr(equal + 1);
+        } else {
+            return false;
+        }
+    }
+    if (opts.tx_key.empty() && std::getenv("ORNG_ORACLE_TX_KEY")) {
+        opts.tx_key = std::getenv("ORNG_ORACLE_TX_KEY");
+    }
+    return !opts.tx_key.empty() && !opts.rsa_keys.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    options opts;
+    try {
+        if (!parse_options(argc, argv, opts)) {
+            return usage();
+        }
+    } catch (const std::exception& e) {
+        return usage(e.what());
+    }
+
+    std::map<uint64_t, pkey_ptr> rsa_keys;
+    std::set<uint64_t> loaded_keys;
+    std::optional<submitter> submit_stage;
+    counters counts;
+    try {
+        for (const auto& [id, path] : opts.rsa_keys) {
+            rsa_keys.emplace(id, load_rsa_key(path));
+            loaded_keys.insert(id);
+        }
+        submit_stage.emplace(opts, counts);
+    } catch (const std::exception& e) {
+        return usage(e.what());
+    }
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    // a few batches of slack per stage, more would only delay the retries
+    stage_queue<job> jobs(opts.threads * opts.batch * 4);
+    stage_queue<result> results(opts.batch * 4);
+
+    const auto start = steady_clock::now();
+    std::thread poller(poll_jobs, std::cref(opts), std::ref(jobs), std::cref(loaded_keys));
+    std::vector<std::thread> signers;
+    for (unsigned i = 0; i < opts.threads; ++i) {
+        signers.emplace_back(sign_jobs, std::cref(rsa_keys), std::ref(jobs), std::ref(results), std::ref(counts));
+    }
+    std::thread submit_thread([&] { submit_stage->run(results); });
+    std::thread streamer(serve_streams, std::cref(opts), std::cref(rsa_keys), std::ref(counts));
+
+    auto report = [&](const char* prefix, steady_clock::time_point since, uint64_t signed_before, uint64_t fulfilled_before) {
+        const double seconds = std::chrono::duration<double>(steady_clock::now() - since).count();
+        log(prefix, "signed ", counts.signed_jobs.load(), " (", (counts.signed_jobs - signed_before) / seconds, " signatures/s), fulfilled ",
+            counts.fulfilled.load(), " (", (counts.fulfilled - fulfilled_before) / seconds, " jobs/s), failed ", counts.failed.load(),
+            ", stream values ", counts.streamed.load());
+    };
+    auto last_report = start;
+    uint64_t last_signed = 0;
+    uint64_t last_fulfilled = 0;
+    while (!stopping) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (steady_clock::now() - last_report >= std::chrono::seconds(opts.report_s)) {
+            report("", last_report, last_signed, last_fulfilled);
+            last_report = steady_clock::now();
+            last_signed = counts.signed_jobs;
+            last_fulfilled = counts.fulfilled;
+        }
+    }
+
+    // the stages drain in order: nothing more is polled, signed, then submitted
+    jobs.close();
+    poller.join();
+    for (auto& signer : signers) {
+        signer.join();
+    }
+    results.close();
+    submit_thread.join();
+    streamer.join();
+
+    report("total: ", start, 0, 0);
+    return counts.failed == 0 ? 0 : 1;
+}
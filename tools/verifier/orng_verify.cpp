@@ -0,0 +1,411 @@
+// MIT License
+//
+// Copyright (c) 2019 worldwide-asset-exchange
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Audits fulfilled jobs off chain: every signature is verified against its
+// public key as setrand does, and the random value delivered to receiverand
+// is recomputed as sha256 of the signature hex, or value i of the ones
+// delivered to receiverands as sha256 of the signature hex followed by i as a
+// little-endian uint32. Records are verified by a pool of worker threads and
+// each mismatch is written as soon as it is found.
+//
+//   orng_verify --keys KEYS [--threads N] [JOBS]
+//
+// KEYS has one key per line, `id,exponent,modulus` in hex, as exported from
+// sigpubkey.b or sigpubkey.c. JOBS, or the standard input, has one job per
+// line, `job_id,key_id,signing_value,signature[,random_value[,derived[,count]]]`,
+// the random value being the checksum256 received by the dapp, or the count
+// values received separated by `;`, which may be left empty, derived being 1
+// for the jobs whose signing value was derived by the contract and count the
+// number of values requested, 1 by default. Empty lines and lines starting
+// with # are skipped in both.
+//
+// The mismatches are written to the standard output as `line,job_id,reason`
+// and the totals to the standard error. The exit code is 0 if every job
+// verified, 1 if any did not and 2 on bad usage or keys.
+
+#define OPENSSL_API_COMPAT 0x10100000L
+
+#include <openssl/bn.h>
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+#include <openssl/sha.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t lines_per_batch = 1024;
+constexpr size_t queued_batches_per_thread = 4;
+constexpr uint64_t max_values_per_job = 256; // the count limit of requestrand
+
+struct line_batch {
+    uint64_t                 first_line;
+    std::vector<std::string> lines;
+};
+
+using pkey_ptr = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
+using key_map = std::map<uint64_t, pkey_ptr>;
+
+std::vector<std::string> split(const std::string& line) {
+    std::vector<std::string> fields;
+    std::istringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ',')) {
+        field.erase(0, field.find_first_not_of(" \t\r"));
+        field.erase(field.find_last_not_of(" \t\r") + 1);
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+bool is_skipped(const std::string& line) {
+    const auto first = line.find_first_not_of(" \t\r");
+    return first == std::string::npos || line[first] == '#';
+}
+
+std::optional<uint64_t> parse_uint(const std::string& text) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+        return std::nullopt;
+    }
+    try {
+        return std::stoull(text);
+    } catch (const std::out_of_range&) {
+        return std::nullopt;
+    }
+}
+
+// odd lengths are read with a leading zero, as the contract stores "10001"
+std::optional<std::vector<unsigned char>> hex_to_bytes(const std::string& hex) {
+    const std::string padded = hex.size() % 2 ? "0" + hex : hex;
+    std::vector<unsigned char> bytes(padded.size() / 2);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        unsigned value = 0;
+        for (char c : padded.substr(i * 2, 2)) {
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else return std::nullopt;
+        }
+        bytes[i] = static_cast<unsigned char>(value);
+    }
+    return bytes;
+}
+
+pkey_ptr make_public_key(const std::vector<unsigned char>& exponent, const std::vector<unsigned char>& modulus) {
+    pkey_ptr pkey(EVP_PKEY_new(), &EVP_PKEY_free);
+    RSA* rsa = RSA_new();
+    BIGNUM* n = BN_bin2bn(modulus.data(), static_cast<int>(modulus.size()), nullptr);
+    BIGNUM* e = BN_bin2bn(exponent.data(), static_cast<int>(exponent.size()), nullptr);
+    if (!pkey || !rsa || !n || !e || RSA_set0_key(rsa, n, e, nullptr) != 1) {
+        BN_free(n);
+        BN_free(e);
+        RSA_free(rsa);
+        return pkey_ptr(nullptr, &EVP_PKEY_free);
+    }
+    if (EVP_PKEY_assign_RSA(pkey.get(), rsa) != 1) {
+        RSA_free(rsa);
+        return pkey_ptr(nullptr, &EVP_PKEY_free);
+    }
+    return pkey;
+}
+
+bool load_keys(std::istream& input, key_map& keys) {
+    std::string line;
+    uint64_t line_number = 0;
+    while (std::getline(input, line)) {
+        ++line_number;
+        if (is_skipped(line)) {
+            continue;
+        }
+        const auto fields = split(line);
+        const auto id = fields.size() == 3 ? parse_uint(fields[0]) : std::nullopt;
+        if (!id) {
+            // a header line is the only one allowed not to start with an id
+            if (keys.empty() && line_number == 1) {
+                continue;
+            }
+            std::cerr << "keys line " << line_number << ": expected id,exponent,modulus\n";
+            return false;
+        }
+        const auto exponent = hex_to_bytes(fields[1]);
+        const auto modulus = hex_to_bytes(fields[2]);
+        auto pkey = exponent && modulus ? make_public_key(*exponent, *modulus) : pkey_ptr(nullptr, &EVP_PKEY_free);
+        if (!pkey) {
+            std::cerr << "keys line " << line_number << ": invalid key\n";
+            return false;
+        }
+        keys.insert_or_assign(*id, std::move(pkey));
+    }
+    return true;
+}
+
+std::string to_hex(const unsigned char* data, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(size * 2, '0');
+    for (size_t i = 0; i < size; ++i) {
+        hex[i * 2] = digits[data[i] >> 4];
+        hex[i * 2 + 1] = digits[data[i] & 0x0f];
+    }
+    return hex;
+}
+
+// Verifies one job as setrand and receiverand see it, returns the mismatch
+// reason or an empty string
+std::string verify_job(const std::vector<std::string>& fields, const key_map& keys, EVP_MD_CTX* md_ctx) {
+    if (fields.size() < 4 || fields.size() > 7) {
+        return "malformed record";
+    }
+    const auto job_id = parse_uint(fields[0]);
+    const auto key_id = parse_uint(fields[1]);
+    const auto signing_value = parse_uint(fields[2]);
+    const auto signature = hex_to_bytes(fields[3]);
+    const bool derived = fields.size() >= 6 && fields[5] == "1";
+    const auto count = fields.size() == 7 ? parse_uint(fields[6]) : std::optional<uint64_t>(1);
+    if (!job_id || !key_id || !signing_value || !signature || (fields.size() >= 6 && !derived && fields[5] != "0") ||
+        !count || *count < 1 || *count > max_values_per_job) {
+        return "malformed record";
+    }
+    const auto key_it = keys.find(*key_id);
+    if (key_it == keys.end()) {
+        return "unknown key";
+    }
+
+    // the signed message is the signing value as a little-endian uint64,
+    // followed by the job id for derived signing values
+    unsigned char message[2 * sizeof(uint64_t)];
+    for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+        message[i] = static_cast<unsigned char>(*signing_value >> (8 * i));
+        message[sizeof(uint64_t) + i] = static_cast<unsigned char>(*job_id >> (8 * i));
+    }
+    const size_t message_size = derived ? sizeof(message) : sizeof(uint64_t);
+    EVP_MD_CTX_reset(md_ctx);
+    if (EVP_DigestVerifyInit(md_ctx, nullptr, EVP_sha256(), nullptr, key_it->second.get()) != 1 ||
+        EVP_DigestVerify(md_ctx, signature->data(), signature->size(), message, message_size) != 1) {
+        return "bad signature";
+    }
+
+    if (fields.size() < 5 || fields[4].empty()) {
+        return {};
+    }
+    std::string delivered = fields[4];
+    std::transform(delivered.begin(), delivered.end(), delivered.begin(), ::tolower);
+    std::vector<std::string> values;
+    std::istringstream stream(delivered);
+    for (std::string value; std::getline(stream, value, ';');) {
+        values.push_back(value);
+    }
+    if (values.size() != *count) {
+        return "random value count mismatch";
+    }
+
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    if (*count == 1) {
+        SHA256(reinterpret_cast<const unsigned char*>(fields[3].data()), fields[3].size(), digest);
+        return to_hex(digest, sizeof(digest)) == values[0] ? std::string() : "random value mismatch";
+    }
+    std::string buffer = fields[3] + std::string(sizeof(uint32_t), '\0');
+    for (uint32_t i = 0; i < values.size(); ++i) {
+        for (size_t b = 0; b < sizeof(uint32_t); ++b) {
+            buffer[fields[3].size() + b] = static_cast<char>(i >> (8 * b));
+        }
+        SHA256(reinterpret_cast<const unsigned char*>(buffer.data()), buffer.size(), digest);
+        if (to_hex(digest, sizeof(digest)) != values[i]) {
+            return "random value mismatch";
+        }
+    }
+    return {};
+}
+
+// Bounded queue of line batches, so the reader never runs far ahead of the workers
+class batch_queue {
+public:
+    explicit batch_queue(size_t capacity) : capacity(capacity) {}
+
+    void push(line_batch batch) {
+        std::unique_lock lock(mutex);
+        not_full.wait(lock, [&] { return batches.size() < capacity; });
+        batches.push_back(std::move(batch));
+        not_empty.notify_one();
+    }
+
+    std::optional<line_batch> pop() {
+        std::unique_lock lock(mutex);
+        not_empty.wait(lock, [&] { return !batches.empty() || closed; });
+        if (batches.empty()) {
+            return std::nullopt;
+        }
+        line_batch batch = std::move(batches.front());
+        batches.pop_front();
+        not_full.notify_one();
+        return batch;
+    }
+
+    void close() {
+        std::lock_guard lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+    }
+
+private:
+    const size_t            capacity;
+    std::deque<line_batch>  batches;
+    bool                    closed = false;
+    std::mutex              mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+};
+
+struct totals {
+    std::atomic<uint64_t> jobs{0};
+    std::atomic<uint64_t> mismatches{0};
+};
+
+void verify_batches(batch_queue& queue, const key_map& keys, std::mutex& output_mutex, totals& counts) {
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> md_ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+    std::string report;
+    while (auto batch = queue.pop()) {
+        uint64_t jobs = 0;
+        uint64_t mismatches = 0;
+        for (size_t i = 0; i < batch->lines.size(); ++i) {
+            const auto& line = batch->lines[i];
+            if (is_skipped(line)) {
+                continue;
+            }
+            const auto fields = split(line);
+            ++jobs;
+            const std::string reason = verify_job(fields, keys, md_ctx.get());
+            if (!reason.empty()) {
+                ++mismatches;
+                report += std::to_string(batch->first_line + i) + "," + (fields.empty() ? "" : fields[0]) + "," + reason + "\n";
+            }
+        }
+        counts.jobs += jobs;
+        counts.mismatches += mismatches;
+        if (!report.empty()) {
+            std::lock_guard lock(output_mutex);
+            std::cout << report << std::flush;
+            report.clear();
+        }
+    }
+}
+
+int usage() {
+    std::cerr << "usage: orng_verify --keys KEYS [--threads N] [JOBS]\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string keys_path;
+    std::string jobs_path;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--keys" && i + 1 < argc) {
+            keys_path = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            const auto value = parse_uint(argv[++i]);
+            if (!value || *value == 0) {
+                return usage();
+            }
+            threads = static_cast<unsigned>(*value);
+        } else if (jobs_path.empty() && arg.rfind("--", 0) != 0) {
+            jobs_path = arg;
+        } else {
+            return usage();
+        }
+    }
+    if (keys_path.empty()) {
+        return usage();
+    }
+
+    key_map keys;
+    std::ifstream keys_file(keys_path);
+    if (!keys_file) {
+        std::cerr << "cannot open " << keys_path << "\n";
+        return 2;
+    }
+    if (!load_keys(keys_file, keys)) {
+        return 2;
+    }
+
+    std::ifstream jobs_file;
+    if (!jobs_path.empty() && jobs_path != "-") {
+        jobs_file.open(jobs_path);
+        if (!jobs_file) {
+            std::cerr << "cannot open " << jobs_path << "\n";
+            return 2;
+        }
+    }
+    std::istream& jobs_input = jobs_file.is_open() ? jobs_file : std::cin;
+
+    const auto start = std::chrono::steady_clock::now();
+    batch_queue queue(threads * queued_batches_per_thread);
+    std::mutex output_mutex;
+    totals counts;
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back(verify_batches, std::ref(queue), std::cref(keys), std::ref(output_mutex), std::ref(counts));
+    }
+
+    line_batch batch{1, {}};
+    uint64_t line_number = 0;
+    std::string line;
+    while (std::getline(jobs_input, line)) {
+        ++line_number;
+        batch.lines.push_back(std::move(line));
+        if (batch.lines.size() == lines_per_batch) {
+            queue.push(std::move(batch));
+            batch = line_batch{line_number + 1, {}};
+        }
+    }
+    if (!batch.lines.empty()) {
+        queue.push(std::move(batch));
+    }
+    queue.close();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cerr << counts.jobs << " jobs, " << counts.mismatches << " mismatches, "
+              << threads << " threads, " << elapsed.count() << " s\n";
+    return counts.mismatches == 0 ? 0 : 1;
+}